@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "algebra.h"
+
+/* An integer value in the form sign * x + offset (sign is +1 or -1) */
+typedef struct {
+    TACOperand x;
+    int sign;
+    int offset;
+} Linear;
+
+static int isConst(TACOperand op) {
+    return op.kind == OPR_INT;
+}
+
+/* Variable or temp holding an integer */
+static int isIntVar(TACOperand op) {
+    return (op.kind == OPR_TEMP || op.kind == OPR_SYM) && !isFloatOperand(op);
+}
+
+/* Integer SSA value: its value cannot change between two program points */
+static int isIntValue(SSAForm* ssa, TACOperand op) {
+    return isIntVar(op) && ssaName(ssa, op) >= 0;
+}
+
+/* Defining instruction of an SSA value, NULL if defined on entry or not a value */
+static TACInstr* definition(SSAForm* ssa, TACOperand op) {
+    int name = ssaName(ssa, op);
+    if (name < 0 || ssa->defSite[name] < 0) return NULL;
+    return &ssa->fn->code[ssa->defSite[name]];
+}
+
+/* The value a chain of copies starts from */
+static TACOperand copyRoot(SSAForm* ssa, TACOperand op) {
+    TACInstr* def = definition(ssa, op);
+    while (def && def->op == TAC_ASSIGN && isIntValue(ssa, def->arg1)) {
+        op = def->arg1;
+        def = definition(ssa, op);
+    }
+    return op;
+}
+
+/* Express op as sign * x + offset through its ADD/SUB definition; returns
+   1 if it looked through one, 0 if op itself is x */
+static int linearOf(SSAForm* ssa, TACOperand op, Linear* form) {
+    form->x = op;
+    form->sign = 1;
+    form->offset = 0;
+    TACInstr* def = definition(ssa, copyRoot(ssa, op));
+    if (!def || (def->op != TAC_ADD && def->op != TAC_SUB)) return 0;
+
+    if (isConst(def->arg2) && isIntValue(ssa, def->arg1)) {
+        form->x = def->arg1;
+        form->offset = def->op == TAC_ADD ? def->arg2.u.ival : (int)(0u - (unsigned)def->arg2.u.ival);
+        return 1;
+    }
+    if (isConst(def->arg1) && isIntValue(ssa, def->arg2)) {
+        form->x = def->arg2;
+        form->sign = def->op == TAC_ADD ? 1 : -1;
+        form->offset = def->arg1.u.ival;
+        return 1;
+    }
+    return 0;
+}
+
+static void setInstr(TACInstr* in, TACOp op, TACOperand arg1, TACOperand arg2) {
+    *in = createTAC(op, arg1, arg2, in->result);
+}
+
+/* Write sign * x + offset into in, canonically */
+static void setLinear(TACInstr* in, Linear form) {
+    if (form.sign < 0) setInstr(in, TAC_SUB, intOperand(form.offset), form.x);
+    else if (form.offset == 0) setInstr(in, TAC_ASSIGN, form.x, noOperand());
+    else if (form.offset < 0 && form.offset != INT_MIN) setInstr(in, TAC_SUB, form.x, intOperand(-form.offset));
+    else setInstr(in, TAC_ADD, form.x, intOperand(form.offset));
+}
+
+/* Write x * factor into in, applying the 0, 1 and -1 identities */
+static void setProduct(TACInstr* in, TACOperand x, int factor) {
+    if (factor == 0) setInstr(in, TAC_ASSIGN, intOperand(0), noOperand());
+    else if (factor == 1) setInstr(in, TAC_ASSIGN, x, noOperand());
+    else if (factor == -1) setInstr(in, TAC_SUB, intOperand(0), x);
+    else setInstr(in, TAC_MUL, x, intOperand(factor));
+}
+
+/* ADD/SUB with one constant operand: fold into the operand's own offset */
+static void simplifyAddSub(SSAForm* ssa, TACInstr* in) {
+    TACOperand a, c;
+    int negateA = 0;
+    if (isConst(in->arg2) && isIntVar(in->arg1)) {
+        a = in->arg1;
+        c = in->arg2;
+        if (in->op == TAC_SUB) c.u.ival = (int)(0u - (unsigned)c.u.ival);
+    } else if (isConst(in->arg1) && isIntVar(in->arg2)) {
+        a = in->arg2;
+        c = in->arg1;
+        negateA = in->op == TAC_SUB;
+    } else {
+        TACOperand l = isIntValue(ssa, in->arg1) ? copyRoot(ssa, in->arg1) : in->arg1;
+        TACOperand r = isIntValue(ssa, in->arg2) ? copyRoot(ssa, in->arg2) : in->arg2;
+        if (in->op == TAC_SUB && isIntVar(l) && sameOperand(l, r)) {
+            setInstr(in, TAC_ASSIGN, intOperand(0), noOperand());
+            optStats.algebraicIdentities++;
+        }
+        return;
+    }
+
+    /* in = (negateA ? -a : a) + c, with a = sign * x + offset */
+    Linear form;
+    int through = isIntValue(ssa, a) && linearOf(ssa, a, &form);
+    if (!through) {
+        form.x = a;
+        form.sign = 1;
+        form.offset = 0;
+    }
+    if (negateA) {
+        form.sign = -form.sign;
+        form.offset = (int)(0u - (unsigned)form.offset);
+    }
+    form.offset = (int)((unsigned)form.offset + (unsigned)c.u.ival);
+    setLinear(in, form);
+
+    if (through) optStats.reassociated++;
+    else if (in->op == TAC_ASSIGN) optStats.algebraicIdentities++;
+}
+
+/* MUL with one constant operand: fold into the operand's own factor */
+static void simplifyMul(SSAForm* ssa, TACInstr* in) {
+    TACOperand x = in->arg1, c = in->arg2;
+    if (isConst(x)) {
+        x = in->arg2;
+        c = in->arg1;
+    }
+    if (!isConst(c) || !isIntVar(x)) return;
+
+    int factor = c.u.ival;
+    int through = 0;
+    TACInstr* def = isIntValue(ssa, x) ? definition(ssa, copyRoot(ssa, x)) : NULL;
+    if (def && def->op == TAC_MUL) {
+        TACOperand inner = def->arg1, innerConst = def->arg2;
+        if (isConst(inner)) {
+            inner = def->arg2;
+            innerConst = def->arg1;
+        }
+        if (isConst(innerConst) && isIntValue(ssa, inner)) {
+            x = inner;
+            factor = (int)((unsigned)factor * (unsigned)innerConst.u.ival);
+            through = 1;
+        }
+    }
+    setProduct(in, x, factor);
+
+    if (through) optStats.reassociated++;
+    else if (in->op != TAC_MUL) optStats.algebraicIdentities++;
+}
+
+/* DIV by 1 or -1 */
+static void simplifyDiv(TACInstr* in) {
+    if (!isConst(in->arg2) || !isIntVar(in->arg1)) return;
+    if (in->arg2.u.ival == 1) setInstr(in, TAC_ASSIGN, in->arg1, noOperand());
+    else if (in->arg2.u.ival == -1) setInstr(in, TAC_SUB, intOperand(0), in->arg1);
+    else return;
+    optStats.algebraicIdentities++;
+}
+
+void simplifyAlgebra(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    inferFloatTemps(fn);
+
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        if (isFloatOperand(in->result)) continue;
+        switch (in->op) {
+            case TAC_ADD: case TAC_SUB: simplifyAddSub(ssa, in); break;
+            case TAC_MUL: simplifyMul(ssa, in); break;
+            case TAC_DIV: simplifyDiv(in); break;
+            default: break;
+        }
+    }
+    updateSSAChains(ssa);
+}
@@ -0,0 +1,24 @@
+#ifndef ALGEBRA_H
+#define ALGEBRA_H
+
+#include "ssa.h"
+
+/* ALGEBRAIC SIMPLIFICATION
+ * Rewrites integer ADD/SUB/MUL/DIV over a function in SSA form:
+ *
+ *   identities      x + 0, x - 0, x * 1, x / 1  ->  x
+ *                   x - x, x * 0                ->  0
+ *                   x * -1, x / -1              ->  0 - x
+ *   reassociation   (x + c1) + c2  ->  x + (c1 + c2)   (also with SUB and
+ *                   c - x forms),  (x * c1) * c2  ->  x * (c1 * c2)
+ *   canonical form  constants go on the right of ADD/MUL, and x + c with
+ *                   c < 0 is written x - |c|
+ *
+ * Reassociation looks through the SSA definition of an operand, so whole
+ * chains of temps collapse onto their root; the intermediate temps are
+ * left for dead-code elimination. Integer arithmetic wraps, so the
+ * rewrites hold for every input. Float arithmetic is left alone.
+ */
+void simplifyAlgebra(SSAForm* ssa);
+
+#endif
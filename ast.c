@@ -7,34 +7,39 @@
 #include <string.h>
 #include "ast.h"
 
+/* Allocate a node of the given kind; names are bound later by resolveNames */
+static ASTNode* allocNode(NodeType type) {
+    ASTNode* node = malloc(sizeof(ASTNode));
+    node->type = type;
+    node->sym = -1;
+    node->regNeed = 0;
+    return node;
+}
+
 /* Create a number literal node */
 ASTNode* createNum(int value) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_NUM;
+    ASTNode* node = allocNode(NODE_NUM);
     node->data.num = value;  /* Store the integer value */
     return node;
 }
 
 /* Create a float literal node */
 ASTNode* createFloat(double value) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_FNUM;
+    ASTNode* node = allocNode(NODE_FNUM);
     node->data.fnum = value;
     return node;
 }
 
 /* Create a variable reference node */
 ASTNode* createVar(char* name) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_VAR;
+    ASTNode* node = allocNode(NODE_VAR);
     node->data.name = strdup(name);  /* Copy the variable name */
     return node;
 }
 
 /* Create a binary operation node (for addition) */
 ASTNode* createBinOp(char op, ASTNode* left, ASTNode* right) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_BINOP;
+    ASTNode* node = allocNode(NODE_BINOP);
     node->data.binop.op = op;        /* Store operator (+) */
     node->data.binop.left = left;    /* Left subtree */
     node->data.binop.right = right;  /* Right subtree */
@@ -43,24 +48,21 @@ ASTNode* createBinOp(char op, ASTNode* left, ASTNode* right) {
 
 /* Create a variable declaration node */
 ASTNode* createDecl(char* name) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_DECL;
+    ASTNode* node = allocNode(NODE_DECL);
     node->data.name = strdup(name);  /* Store variable name */
     return node;
 }
 
 /* Create a float variable declaration node */
 ASTNode* createDeclFloat(char* name) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_DECL_FLOAT;
+    ASTNode* node = allocNode(NODE_DECL_FLOAT);
     node->data.decl_float.name = strdup(name);
     return node;
 }
 
 /* Create an assignment statement node */
 ASTNode* createAssign(char* var, ASTNode* value) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_ASSIGN;
+    ASTNode* node = allocNode(NODE_ASSIGN);
     node->data.assign.var = strdup(var);  /* Variable name */
     node->data.assign.value = value;      /* Expression tree */
     return node;
@@ -68,16 +70,14 @@ ASTNode* createAssign(char* var, ASTNode* value) {
 
 /* Create a print statement node */
 ASTNode* createPrint(ASTNode* expr) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_PRINT;
+    ASTNode* node = allocNode(NODE_PRINT);
     node->data.expr = expr;  /* Expression to print */
     return node;
 }
 
 /* Create an array declaration node */
 ASTNode* createArrayDecl(char* name, int size) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_ARRAY_DECL;
+    ASTNode* node = allocNode(NODE_ARRAY_DECL);
     node->data.array_decl.name = strdup(name); /* Array name */
     node->data.array_decl.size = size;         /* Array size */
     return node;
@@ -85,8 +85,7 @@ ASTNode* createArrayDecl(char* name, int size) {
 
 /* Create an array element assignment node */
 ASTNode* createArrayAssign(char* name, ASTNode* index, ASTNode* value) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_ARRAY_ASSIGN;
+    ASTNode* node = allocNode(NODE_ARRAY_ASSIGN);
     node->data.array_assign.name = strdup(name); /* Array name */
     node->data.array_assign.index = index;       /* Index expression */
     node->data.array_assign.value = value;       /* Value expression */
@@ -95,8 +94,7 @@ ASTNode* createArrayAssign(char* name, ASTNode* index, ASTNode* value) {
 
 /* Create an array element access node */
 ASTNode* createArrayAccess(char* name, ASTNode* index) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_ARRAY_ACCESS;
+    ASTNode* node = allocNode(NODE_ARRAY_ACCESS);
     node->data.array_access.name = strdup(name); /* Array name */
     node->data.array_access.index = index;       /* Index expression */
     return node;
@@ -117,8 +115,7 @@ ASTNode* createArrayAccess(char* name, ASTNode* index) {
 
 /* Create a statement list node (links statements together) */
 ASTNode* createStmtList(ASTNode* stmt1, ASTNode* stmt2) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_STMT_LIST;
+    ASTNode* node = allocNode(NODE_STMT_LIST);
     node->data.stmtlist.stmt = stmt1;  /* First statement */
     node->data.stmtlist.next = stmt2;  /* Rest of list */
     return node;
@@ -126,19 +123,18 @@ ASTNode* createStmtList(ASTNode* stmt1, ASTNode* stmt2) {
 
 /* Create a function declaration node */
 ASTNode* createFuncDecl(char* name, ASTNode* params, ASTNode* body, ASTNode* ret) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_FUNC_DECL;
+    ASTNode* node = allocNode(NODE_FUNC_DECL);
     node->data.func_decl.name = strdup(name);
     node->data.func_decl.params = params;
     node->data.func_decl.body = body;
     node->data.func_decl.ret = ret;
+    node->data.func_decl.scope = -1;
     return node;
 }
 
 /* Create a function call node */
 ASTNode* createFuncCall(char* name, ASTNode* args) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_FUNC_CALL;
+    ASTNode* node = allocNode(NODE_FUNC_CALL);
     node->data.func_call.name = strdup(name);
     node->data.func_call.args = args;
     return node;
@@ -146,8 +142,7 @@ ASTNode* createFuncCall(char* name, ASTNode* args) {
 
 /* Parameter list helpers */
 ASTNode* createParamList(char* name, int vtype) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_PARAM_LIST;
+    ASTNode* node = allocNode(NODE_PARAM_LIST);
     node->data.param_list.name = strdup(name);
     node->data.param_list.vtype = vtype;
     node->data.param_list.next = NULL;
@@ -165,8 +160,7 @@ ASTNode* appendParam(ASTNode* list, char* name, int vtype) {
 
 /* Argument list helpers */
 ASTNode* createArgList(ASTNode* expr) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_ARG_LIST;
+    ASTNode* node = allocNode(NODE_ARG_LIST);
     node->data.arg_list.expr = expr;
     node->data.arg_list.next = NULL;
     return node;
@@ -183,8 +177,7 @@ ASTNode* appendArg(ASTNode* list, ASTNode* expr) {
 
 /* Return statement node */
 ASTNode* createReturn(ASTNode* expr) {
-    ASTNode* node = malloc(sizeof(ASTNode));
-    node->type = NODE_RETURN;
+    ASTNode* node = allocNode(NODE_RETURN);
     node->data.return_expr = expr;
     return node;
 }
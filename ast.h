@@ -44,6 +44,11 @@ typedef enum {
  */
 typedef struct ASTNode {
     NodeType type;  /* Identifies what kind of node this is */
+    int sym;        /* Symbol id bound by resolveNames (-1 if none): set on
+                       declarations, variable uses, assignments, array
+                       accesses and parameters */
+    int regNeed;    /* Registers the code generator needs for this expression
+                       (Sethi-Ullman number), 0 until computed */
     
     /* Union allows same memory to store different data types */
     union {
@@ -109,6 +114,7 @@ typedef struct ASTNode {
             struct ASTNode* params;   /* Parameter list */
             struct ASTNode* body;     /* Body statement list */
             struct ASTNode* ret;      /* Return expression (wrapped in return node) */
+            int scope;                /* Symbol table scope of the body */
         } func_decl;
 
         /* Function call (NODE_FUNC_CALL) */
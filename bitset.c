@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitset.h"
+
+#define WORD_BITS ((int)(sizeof(unsigned long) * 8))
+
+Bitset* bitsetCreate(int size) {
+    Bitset* set = malloc(sizeof(Bitset));
+    if (!set) {
+        fprintf(stderr, "Out of memory in bitset\n");
+        exit(1);
+    }
+    set->size = size;
+    set->wordCount = (size + WORD_BITS - 1) / WORD_BITS;
+    set->words = calloc(set->wordCount ? set->wordCount : 1, sizeof(unsigned long));
+    if (!set->words) {
+        fprintf(stderr, "Out of memory in bitset\n");
+        exit(1);
+    }
+    return set;
+}
+
+void bitsetFree(Bitset* set) {
+    if (!set) return;
+    free(set->words);
+    free(set);
+}
+
+void bitsetAdd(Bitset* set, int member) {
+    set->words[member / WORD_BITS] |= 1UL << (member % WORD_BITS);
+}
+
+void bitsetRemove(Bitset* set, int member) {
+    set->words[member / WORD_BITS] &= ~(1UL << (member % WORD_BITS));
+}
+
+int bitsetContains(const Bitset* set, int member) {
+    return (set->words[member / WORD_BITS] >> (member % WORD_BITS)) & 1UL;
+}
+
+void bitsetClearAll(Bitset* set) {
+    memset(set->words, 0, sizeof(unsigned long) * set->wordCount);
+}
+
+void bitsetCopy(Bitset* dst, const Bitset* src) {
+    memcpy(dst->words, src->words, sizeof(unsigned long) * src->wordCount);
+}
+
+int bitsetUnion(Bitset* dst, const Bitset* src) {
+    unsigned long changed = 0;
+    for (int i = 0; i < src->wordCount; i++) {
+        unsigned long merged = dst->words[i] | src->words[i];
+        changed |= merged ^ dst->words[i];
+        dst->words[i] = merged;
+    }
+    return changed != 0;
+}
+
+void bitsetSubtract(Bitset* dst, const Bitset* src) {
+    for (int i = 0; i < src->wordCount; i++) dst->words[i] &= ~src->words[i];
+}
@@ -0,0 +1,24 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+/* BITSET
+ * Fixed-size dense set of small integers (value ids, block ids, ...),
+ * one bit per member, used by the dataflow passes over TAC.
+ */
+typedef struct {
+    unsigned long* words;   /* Bit storage */
+    int size;               /* Number of representable members */
+    int wordCount;          /* Words allocated */
+} Bitset;
+
+Bitset* bitsetCreate(int size);                        /* Empty set for members 0..size-1 */
+void bitsetFree(Bitset* set);
+void bitsetAdd(Bitset* set, int member);
+void bitsetRemove(Bitset* set, int member);
+int bitsetContains(const Bitset* set, int member);
+void bitsetClearAll(Bitset* set);                      /* Remove every member */
+void bitsetCopy(Bitset* dst, const Bitset* src);       /* dst = src (same size) */
+int bitsetUnion(Bitset* dst, const Bitset* src);       /* dst |= src, returns 1 if dst changed */
+void bitsetSubtract(Bitset* dst, const Bitset* src);   /* dst &= ~src */
+
+#endif
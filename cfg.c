@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "cfg.h"
+
+static void* xmalloc(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Out of memory in CFG\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in CFG\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void addEdge(CFG* cfg, int from, int to) {
+    BasicBlock* a = &cfg->blocks[from];
+    BasicBlock* b = &cfg->blocks[to];
+    a->succs = realloc(a->succs, sizeof(int) * (a->succCount + 1));
+    b->preds = realloc(b->preds, sizeof(int) * (b->predCount + 1));
+    if (!a->succs || !b->preds) {
+        fprintf(stderr, "Out of memory in CFG\n");
+        exit(1);
+    }
+    a->succs[a->succCount++] = to;
+    b->preds[b->predCount++] = from;
+}
+
+/* Does the block end by leaving the function? */
+static int endsWithReturn(CFG* cfg, BasicBlock* b) {
+    return b->last > b->first && cfg->fn->code[b->last - 1].op == TAC_RETURN;
+}
+
+/* Reverse post-order of the blocks reachable from entry (iterative DFS) */
+static void computeRPO(CFG* cfg) {
+    int n = cfg->blockCount;
+    int* stack = xmalloc(sizeof(int) * n);
+    int* nextSucc = xmalloc(sizeof(int) * n);
+    char* visited = xcalloc(n, 1);
+    int* post = xmalloc(sizeof(int) * n);
+    int postCount = 0;
+    int sp = 0;
+
+    stack[sp++] = cfg->entry;
+    visited[cfg->entry] = 1;
+    nextSucc[cfg->entry] = 0;
+    while (sp > 0) {
+        BasicBlock* b = &cfg->blocks[stack[sp - 1]];
+        if (nextSucc[b->id] < b->succCount) {
+            int s = b->succs[nextSucc[b->id]++];
+            if (!visited[s]) {
+                visited[s] = 1;
+                nextSucc[s] = 0;
+                stack[sp++] = s;
+            }
+        } else {
+            post[postCount++] = b->id;
+            sp--;
+        }
+    }
+
+    cfg->rpo = xmalloc(sizeof(int) * postCount);
+    cfg->rpoCount = postCount;
+    for (int i = 0; i < postCount; i++) {
+        cfg->rpo[i] = post[postCount - 1 - i];
+        cfg->blocks[cfg->rpo[i]].rpo = i;
+    }
+
+    free(stack);
+    free(nextSucc);
+    free(visited);
+    free(post);
+}
+
+CFG* buildCFG(TACFunction* fn) {
+    CFG* cfg = xmalloc(sizeof(CFG));
+    cfg->fn = fn;
+
+    /* Leaders: the first instruction, every label, and whatever follows a return */
+    char* leader = xcalloc(fn->count + 1, 1);
+    int realBlocks = 0;
+    for (int i = 0; i < fn->count; i++) {
+        if (i == 0 || fn->code[i].op == TAC_LABEL || fn->code[i - 1].op == TAC_RETURN) {
+            /* A label right after FUNC_BEGIN starts the same block */
+            if (i > 0 && fn->code[i].op == TAC_LABEL && fn->code[i - 1].op == TAC_FUNC_BEGIN) continue;
+            leader[i] = 1;
+            realBlocks++;
+        }
+    }
+
+    cfg->blockCount = realBlocks + 2;
+    cfg->blocks = xmalloc(sizeof(BasicBlock) * cfg->blockCount);
+    cfg->entry = 0;
+    cfg->exit = cfg->blockCount - 1;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        cfg->blocks[b].id = b;
+        cfg->blocks[b].first = cfg->blocks[b].last = 0;
+        cfg->blocks[b].succs = cfg->blocks[b].preds = NULL;
+        cfg->blocks[b].succCount = cfg->blocks[b].predCount = 0;
+        cfg->blocks[b].rpo = -1;
+    }
+    cfg->blocks[cfg->exit].first = cfg->blocks[cfg->exit].last = fn->count;
+
+    int b = 0;
+    for (int i = 0; i < fn->count; i++) {
+        if (leader[i]) {
+            b++;
+            cfg->blocks[b].first = i;
+        }
+        cfg->blocks[b].last = i + 1;
+    }
+    free(leader);
+
+    /* Edges: straight-line fall-through, returns go to exit */
+    addEdge(cfg, cfg->entry, realBlocks > 0 ? 1 : cfg->exit);
+    for (b = 1; b <= realBlocks; b++) {
+        if (endsWithReturn(cfg, &cfg->blocks[b]) || b == realBlocks) addEdge(cfg, b, cfg->exit);
+        else addEdge(cfg, b, b + 1);
+    }
+
+    computeRPO(cfg);
+    return cfg;
+}
+
+void freeCFG(CFG* cfg) {
+    if (!cfg) return;
+    for (int b = 0; b < cfg->blockCount; b++) {
+        free(cfg->blocks[b].succs);
+        free(cfg->blocks[b].preds);
+    }
+    free(cfg->blocks);
+    free(cfg->rpo);
+    free(cfg);
+}
+
+/* Write text escaped for a DOT record label */
+static void writeEscaped(FILE* out, const char* s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\' || *s == '{' || *s == '}' ||
+            *s == '<' || *s == '>' || *s == '|') fputc('\\', out);
+        fputc(*s, out);
+    }
+}
+
+void dumpCFGDot(FILE* out, CFG* cfg) {
+    const char* name = labelName(cfg->fn->name);
+    char text[256];
+
+    fprintf(out, "  subgraph \"cluster_%s\" {\n", name);
+    fprintf(out, "    label=\"%s\";\n", name);
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* blk = &cfg->blocks[b];
+        fprintf(out, "    \"%s_B%d\" [shape=record,label=\"{", name, b);
+        if (b == cfg->entry) fprintf(out, "ENTRY");
+        else if (b == cfg->exit) fprintf(out, "EXIT");
+        else fprintf(out, "B%d%s", b, blk->rpo < 0 ? " (unreachable)" : "");
+        for (int i = blk->first; i < blk->last; i++) {
+            if (cfg->fn->code[i].op == TAC_NOP) continue;
+            fprintf(out, "|");
+            writeEscaped(out, formatTAC(&cfg->fn->code[i], text, sizeof(text)));
+            fprintf(out, "\\l");
+        }
+        fprintf(out, "}\"];\n");
+    }
+    for (int b = 0; b < cfg->blockCount; b++) {
+        for (int s = 0; s < cfg->blocks[b].succCount; s++) {
+            fprintf(out, "    \"%s_B%d\" -> \"%s_B%d\";\n", name, b, name, cfg->blocks[b].succs[s]);
+        }
+    }
+    fprintf(out, "  }\n");
+}
+
+void dumpProgramCFGs(const char* path) {
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Error: Cannot open CFG dump file '%s'\n", path);
+        exit(1);
+    }
+    fprintf(out, "digraph CFG {\n");
+    fprintf(out, "  node [fontname=\"monospace\"];\n");
+    for (int f = 0; f < tacProgram.funcCount; f++) {
+        CFG* cfg = buildCFG(&tacProgram.funcs[f]);
+        dumpCFGDot(out, cfg);
+        freeCFG(cfg);
+    }
+    fprintf(out, "}\n");
+    fclose(out);
+}
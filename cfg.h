@@ -0,0 +1,43 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdio.h>
+#include "tac.h"
+
+/* CONTROL-FLOW GRAPH
+ * Splits one TAC function into basic blocks: maximal runs of instructions
+ * entered only at the top and left only at the bottom. Blocks refer to
+ * their instructions by index range, so a CFG must be rebuilt after the
+ * function is compacted.
+ *
+ * Block 0 is a synthetic empty entry block and the last block a synthetic
+ * empty exit block; every return and the end of the function flow to exit.
+ */
+
+typedef struct {
+    int id;             /* Index in CFG.blocks */
+    int first;          /* First instruction index */
+    int last;           /* One past the last instruction index */
+    int* succs;         /* Successor block ids */
+    int succCount;
+    int* preds;         /* Predecessor block ids */
+    int predCount;
+    int rpo;            /* Position in reverse post-order, -1 if unreachable */
+} BasicBlock;
+
+typedef struct {
+    TACFunction* fn;    /* Function the graph describes */
+    BasicBlock* blocks;
+    int blockCount;
+    int entry;          /* Synthetic entry block (0) */
+    int exit;           /* Synthetic exit block (blockCount - 1) */
+    int* rpo;           /* Reachable block ids in reverse post-order */
+    int rpoCount;
+} CFG;
+
+CFG* buildCFG(TACFunction* fn);            /* Build blocks, edges and RPO */
+void freeCFG(CFG* cfg);
+void dumpCFGDot(FILE* out, CFG* cfg);      /* Write one cluster per function in DOT syntax */
+void dumpProgramCFGs(const char* path);    /* DOT file with the CFG of every function */
+
+#endif
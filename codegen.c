@@ -1,87 +1,601 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "codegen.h"
 #include "symtab.h"
+#include "strength.h"
 
 FILE* output;
 int tempReg = 0;
 
+/* STACK FRAMES
+ * main and every function get a frame sized exactly for what they use.
+ * Offsets below are relative to $sp right after the prologue:
+ *
+ *     [0, locals)                scalars and arrays declared in the scope
+ *                                (parameters excepted, see below)
+ *     [locals, locals + spill)   spill slots: $t registers parked around
+ *                                calls and expression values parked when
+ *                                an expression needs more than $t0-$t7
+ *     frame-4                    saved $ra (functions that make calls)
+ *     [frame, frame + 4n)        the n arguments the caller pushed; they
+ *                                are the parameters' home
+ *
+ * There is no frame pointer: everything is addressed off $sp. A leaf
+ * function (no calls other than tail calls) keeps $ra in its register,
+ * and one with no locals and no spills does not move $sp at all.
+ * Each body is generated into a memory buffer first, so the prologue can
+ * be written once the spill area is known. Outgoing call arguments are
+ * pushed below the frame; spDelta tracks how far $sp has moved so that
+ * frame slots stay addressable while arguments are being pushed.
+ */
+static int spillBase = 0;       /* offset of the spill area (= locals size) */
+static int spillBytes = 0;      /* spill area the current frame needs */
+static int spillTop = 0;        /* spill slots in use; they are used as a stack */
+static int spDelta = 0;         /* bytes of outgoing args currently pushed */
+static int inFunction = 0;      /* generating a function body (not main) */
+static int usesGlobalBase = 0;  /* some function reached a global via $gp */
+static const char* retLabel;    /* epilogue label of the current frame */
+static int retJumped = 0;       /* some return branched to retLabel */
+static ASTNode* tailReturn;     /* return that falls straight into the epilogue */
+static ASTNode* currentFunc;    /* function being generated (NULL in main) */
+static const char* entryLabel;  /* start of the current function's parameter copies */
+static int entryJumped = 0;     /* a self tail call branched to entryLabel */
+static int endsInTailCall = 0;  /* tailReturn was a tail call: the epilogue is only reached by jumps */
+static int frameScope = 0;      /* scope of the current function */
+static int frameParams = 0;     /* its parameter count */
+static int frameSize = 0;       /* its frame size, as far as known while generating the body */
+static int frameUsed = 0;       /* the body addressed the argument slots (depends on frameSize) */
+static int savesRa = 0;         /* it saves $ra at frameSize - 4 */
+static FILE* funcOutput;        /* code of all functions, emitted after main */
+
+void genStmt(ASTNode* node);
+void genExpr(ASTNode* node);
+static int isTailCall(ASTNode* node);
+
+/* EXPRESSION REGISTERS
+ * $t0-$t7 are used as a stack: tempReg is the number in use and an
+ * expression leaves its value in the register it started at. Evaluation
+ * order follows Sethi-Ullman numbering, so an expression never needs
+ * more registers than that; if even that is more than are left, one
+ * operand is parked in a spill slot while the other is computed.
+ */
+#define TEMP_REGS 8
+
 int getNextTemp() {
-    int reg = tempReg++;
-    if (tempReg > 7) tempReg = 0;  // Reuse $t0-$t7
-    return reg;
+    if (tempReg >= TEMP_REGS) {
+        fprintf(stderr, "Internal error: out of temporary registers\n");
+        exit(1);
+    }
+    return tempReg++;
+}
+
+/* Park $t<reg> in the next spill slot */
+static void pushSpill(int reg) {
+    fprintf(output, "    sw $t%d, %d($sp)\n", reg, spillBase + spillTop * 4 + spDelta);
+    spillTop++;
+    if (spillTop * 4 > spillBytes) spillBytes = spillTop * 4;
+}
+
+/* Reload the most recently parked value into $t<reg> */
+static void popSpill(int reg) {
+    spillTop--;
+    fprintf(output, "    lw $t%d, %d($sp)\n", reg, spillBase + spillTop * 4 + spDelta);
+}
+
+/* Last statement of a (left-nested) statement list */
+static ASTNode* lastStmt(ASTNode* node) {
+    while (node && node->type == NODE_STMT_LIST) node = node->data.stmtlist.next;
+    return node;
+}
+
+/* Offset of a variable in the current frame. Parameters come first in
+   their scope, one word each, and live in the caller's argument slots */
+static int frameOffset(Symbol* sym) {
+    if (!inFunction || sym->scope != frameScope) return sym->offset;
+    int param = sym->offset / 4;
+    if (param < frameParams) {
+        frameUsed = 1;
+        return frameSize + (frameParams - 1 - param) * 4;
+    }
+    return sym->offset - frameParams * 4;
+}
+
+/* Base register and displacement of a variable's storage. Globals seen
+   from inside a function are reached through $gp, which main points at
+   its own frame. */
+static const char* varBase(Symbol* sym, int* offset) {
+    if (inFunction && sym->scope == 0) {
+        usesGlobalBase = 1;
+        *offset = sym->offset;
+        return "$gp";
+    }
+    *offset = frameOffset(sym) + spDelta;
+    return "$sp";
+}
+
+/* Turn the index in $t<reg> into the address of element 0 of sym
+   (plus the index), returning the displacement to use with it */
+static int genElementAddress(Symbol* sym, int reg) {
+    int offset;
+    const char* base = varBase(sym, &offset);
+    fprintf(output, "    sll $t%d, $t%d, 2\n", reg, reg);
+    fprintf(output, "    add $t%d, $t%d, %s\n", reg, reg, base);
+    return offset;
+}
+
+/* STRENGTH REDUCTION
+ * Multiplication and division by a constant use the shift/add plans from
+ * strength.c instead of mult/div + mflo. The other operand is evaluated
+ * into reg; the result is left in reg. The sequences use addu/subu so
+ * they wrap on overflow like the mult/div they replace instead of trapping.
+ */
+static void genMultiplyByConst(int reg, MulPlan* plan) {
+    if (plan->count == 1) {
+        fprintf(output, "    sll $t%d, $t%d, %d\n", reg, reg, plan->shift[0]);
+    } else {
+        int sum = getNextTemp();
+        int term = getNextTemp();
+        fprintf(output, "    sll $t%d, $t%d, %d\n", sum, reg, plan->shift[0]);
+        for (int i = 1; i < plan->count; i++) {
+            int src = reg;
+            if (plan->shift[i] > 0) {
+                fprintf(output, "    sll $t%d, $t%d, %d\n", term, reg, plan->shift[i]);
+                src = term;
+            }
+            int dest = i == plan->count - 1 ? reg : sum;
+            fprintf(output, "    %s $t%d, $t%d, $t%d\n", plan->sign[i] > 0 ? "addu" : "subu", dest, sum, src);
+        }
+    }
+    if (plan->negate) fprintf(output, "    subu $t%d, $zero, $t%d\n", reg, reg);
+}
+
+/* Signed division by 2^k: bias negative dividends by 2^k - 1 so the
+   arithmetic shift rounds toward zero like div does */
+static void genDivideByConst(int reg, int k, int negate) {
+    int bias = getNextTemp();
+    if (k == 1) {
+        fprintf(output, "    srl $t%d, $t%d, 31\n", bias, reg);
+    } else {
+        fprintf(output, "    sra $t%d, $t%d, 31\n", bias, reg);
+        fprintf(output, "    srl $t%d, $t%d, %d\n", bias, bias, 32 - k);
+    }
+    fprintf(output, "    addu $t%d, $t%d, $t%d\n", reg, reg, bias);
+    fprintf(output, "    sra $t%d, $t%d, %d\n", reg, reg, k);
+    if (negate) fprintf(output, "    subu $t%d, $zero, $t%d\n", reg, reg);
+}
+
+/* Signed division by any other constant: the high word of x * M, shifted,
+   plus one when negative (truncation toward zero). mult still runs, but
+   the HI result is ready far sooner than a full div */
+static void genMagicDivide(int reg, DivPlan* plan) {
+    int q = getNextTemp();
+    int sign = getNextTemp();
+    fprintf(output, "    li $t%d, %d\n", q, plan->magic);
+    fprintf(output, "    mult $t%d, $t%d\n", reg, q);
+    fprintf(output, "    mfhi $t%d\n", q);
+    if (plan->addDividend > 0) fprintf(output, "    addu $t%d, $t%d, $t%d\n", q, q, reg);
+    if (plan->addDividend < 0) fprintf(output, "    subu $t%d, $t%d, $t%d\n", q, q, reg);
+    if (plan->shift > 0) fprintf(output, "    sra $t%d, $t%d, %d\n", q, q, plan->shift);
+    fprintf(output, "    srl $t%d, $t%d, 31\n", sign, q);
+    fprintf(output, "    addu $t%d, $t%d, $t%d\n", reg, q, sign);
+}
+
+/* The operand of x * const, const * x or x / const when it is strength
+   reduced, and how many scratch registers the sequence needs; NULL if not */
+static ASTNode* reducedOperand(ASTNode* node, int* scratch) {
+    ASTNode* left = node->data.binop.left;
+    ASTNode* right = node->data.binop.right;
+    MulPlan plan;
+    DivPlan magic;
+    int k, negate;
+
+    if (node->data.binop.op == '*') {
+        ASTNode* operand = NULL;
+        if (right->type == NODE_NUM && planMultiply(right->data.num, &plan)) operand = left;
+        else if (left->type == NODE_NUM && planMultiply(left->data.num, &plan)) operand = right;
+        if (operand) *scratch = plan.count > 1 ? 2 : 0;
+        return operand;
+    }
+    if (node->data.binop.op == '/' && right->type == NODE_NUM) {
+        if (planDivide(right->data.num, &k, &negate)) {
+            *scratch = 1;
+            return left;
+        }
+        if (planMagicDivide(right->data.num, &magic)) {
+            *scratch = 2;
+            return left;
+        }
+    }
+    return NULL;
+}
+
+/* Emit a strength-reduced multiply or divide; 0 if not applicable or the
+   sequence's scratch registers are not free */
+static int genStrengthReduced(ASTNode* node) {
+    int scratch;
+    ASTNode* operand = reducedOperand(node, &scratch);
+    if (!operand || 1 + scratch > TEMP_REGS - tempReg) return 0;
+
+    genExpr(operand);
+    int reg = tempReg - 1;
+    if (node->data.binop.op == '*') {
+        ASTNode* constant = operand == node->data.binop.left ? node->data.binop.right : node->data.binop.left;
+        MulPlan plan;
+        planMultiply(constant->data.num, &plan);
+        genMultiplyByConst(reg, &plan);
+    } else {
+        int divisor = node->data.binop.right->data.num;
+        int k, negate;
+        DivPlan magic;
+        if (planDivide(divisor, &k, &negate)) genDivideByConst(reg, k, negate);
+        else if (planMagicDivide(divisor, &magic)) genMagicDivide(reg, &magic);
+    }
+    tempReg = reg + 1;
+    return 1;
+}
+
+/* Sethi-Ullman number: registers needed to evaluate node without spilling */
+static int regNeed(ASTNode* node) {
+    if (node->regNeed) return node->regNeed;
+    int need = 1;
+    switch (node->type) {
+        case NODE_ARRAY_ACCESS:
+            need = regNeed(node->data.array_access.index);
+            break;
+        case NODE_BINOP: {
+            int scratch;
+            ASTNode* operand = reducedOperand(node, &scratch);
+            int left = regNeed(node->data.binop.left);
+            int right = regNeed(node->data.binop.right);
+            need = left == right ? left + 1 : left > right ? left : right;
+            if (operand) {
+                /* Upper bound for both the reduced and the plain sequence */
+                int reduced = regNeed(operand) > 1 + scratch ? regNeed(operand) : 1 + scratch;
+                if (reduced > need) need = reduced;
+            }
+            break;
+        }
+        default:
+            /* Leaves; a call parks live registers and returns in one */
+            break;
+    }
+    node->regNeed = need;
+    return need;
 }
 
 void genExpr(ASTNode* node) {
     if (!node) return;
-    
+
     switch(node->type) {
         case NODE_NUM:
             fprintf(output, "    li $t%d, %d\n", getNextTemp(), node->data.num);
             break;
-            
+
         case NODE_VAR: {
-            int offset = getVarOffset(node->data.name);
-            if (offset == -1) {
-                fprintf(stderr, "Error: Variable %s not declared\n", node->data.name);
-                exit(1);
-            }
-            fprintf(output, "    lw $t%d, %d($sp)\n", getNextTemp(), offset);
+            int offset;
+            const char* base = varBase(getSymbol(node->sym), &offset);
+            fprintf(output, "    lw $t%d, %d(%s)\n", getNextTemp(), offset, base);
             break;
         }
-        
-        case NODE_BINOP:
-            genExpr(node->data.binop.left);
-            int leftReg = tempReg - 1;
-            genExpr(node->data.binop.right);
-            int rightReg = tempReg - 1;
+
+        case NODE_ARRAY_ACCESS: {
+            Symbol* sym = getSymbol(node->sym);
+            genExpr(node->data.array_access.index);
+            int reg = tempReg - 1;
+            int offset = genElementAddress(sym, reg);
+            fprintf(output, "    lw $t%d, %d($t%d)\n", reg, offset, reg);
+            break;
+        }
+
+        case NODE_BINOP: {
+            if (genStrengthReduced(node)) break;
+            ASTNode* left = node->data.binop.left;
+            ASTNode* right = node->data.binop.right;
+            int base = tempReg;
+            /* The side needing more registers goes first */
+            int rightFirst = regNeed(right) > regNeed(left);
+            genExpr(rightFirst ? right : left);
+            int firstReg = tempReg - 1;
+            int secondReg;
+            if (regNeed(rightFirst ? left : right) > TEMP_REGS - tempReg) {
+                /* Not enough registers left for the other side: park this one */
+                pushSpill(firstReg);
+                tempReg = base;
+                genExpr(rightFirst ? left : right);
+                secondReg = tempReg - 1;
+                firstReg = getNextTemp();
+                popSpill(firstReg);
+            } else {
+                genExpr(rightFirst ? left : right);
+                secondReg = tempReg - 1;
+            }
+            int leftReg = rightFirst ? secondReg : firstReg;
+            int rightReg = rightFirst ? firstReg : secondReg;
             if (node->data.binop.op == '+') {
-                fprintf(output, "    add $t%d, $t%d, $t%d\n", leftReg, leftReg, rightReg);
+                fprintf(output, "    add $t%d, $t%d, $t%d\n", base, leftReg, rightReg);
             } else if (node->data.binop.op == '-') {
-                fprintf(output, "    sub $t%d, $t%d, $t%d\n", leftReg, leftReg, rightReg);
+                fprintf(output, "    sub $t%d, $t%d, $t%d\n", base, leftReg, rightReg);
             } else if (node->data.binop.op == '*') {
                 // use mult and mflo to get product
                 fprintf(output, "    mult $t%d, $t%d\n", leftReg, rightReg);
-                fprintf(output, "    mflo $t%d\n", leftReg);
+                fprintf(output, "    mflo $t%d\n", base);
             } else if (node->data.binop.op == '/') {
                 // use div and mflo to get quotient (integer division)
                 fprintf(output, "    div $t%d, $t%d\n", leftReg, rightReg);
-                fprintf(output, "    mflo $t%d\n", leftReg);
+                fprintf(output, "    mflo $t%d\n", base);
+            }
+            tempReg = base + 1;
+            break;
+        }
+
+        case NODE_FUNC_CALL: {
+            /* $t registers are caller-saved: park the live ones in spill slots */
+            int live = tempReg;
+            for (int r = 0; r < live; r++) pushSpill(r);
+            /* Push arguments left-to-right; each has every register */
+            ASTNode* a = node->data.func_call.args;
+            int argCount = 0;
+            while (a) {
+                tempReg = 0;
+                genExpr(a->data.arg_list.expr);
+                fprintf(output, "    addi $sp, $sp, -4\n");
+                fprintf(output, "    sw $t%d, 0($sp)\n", tempReg - 1);
+                spDelta += 4;
+                argCount++;
+                a = a->data.arg_list.next;
+            }
+            /* Call function */
+            fprintf(output, "    jal %s\n", node->data.func_call.name);
+            /* Pop arguments off stack */
+            if (argCount > 0) {
+                fprintf(output, "    addi $sp, $sp, %d\n", argCount * 4);
+                spDelta -= argCount * 4;
             }
-            tempReg = leftReg + 1;
+            for (int r = live - 1; r >= 0; r--) popSpill(r);
+            tempReg = live;
+            /* After call, return value is in $v0, move to temp reg */
+            fprintf(output, "    move $t%d, $v0\n", getNextTemp());
             break;
-            
+        }
+
         default:
             break;
     }
 }
 
+/* Does code under node need $ra saved: is there a call that is not a tail call? */
+static int makesCalls(ASTNode* node) {
+    if (!node) return 0;
+    switch (node->type) {
+        case NODE_FUNC_CALL:
+            return 1;
+        case NODE_RETURN:
+            if (isTailCall(node->data.return_expr)) {
+                for (ASTNode* a = node->data.return_expr->data.func_call.args; a; a = a->data.arg_list.next) {
+                    if (makesCalls(a->data.arg_list.expr)) return 1;
+                }
+                return 0;
+            }
+            return makesCalls(node->data.return_expr);
+        case NODE_STMT_LIST:
+            return makesCalls(node->data.stmtlist.stmt) || makesCalls(node->data.stmtlist.next);
+        case NODE_ASSIGN:
+            return makesCalls(node->data.assign.value);
+        case NODE_ARRAY_ASSIGN:
+            return makesCalls(node->data.array_assign.index) || makesCalls(node->data.array_assign.value);
+        case NODE_PRINT:
+            return makesCalls(node->data.expr);
+        case NODE_BINOP:
+            return makesCalls(node->data.binop.left) || makesCalls(node->data.binop.right);
+        case NODE_ARRAY_ACCESS:
+            return makesCalls(node->data.array_access.index);
+        default:
+            return 0;
+    }
+}
+
+/* TAIL CALLS
+ * In return f(args) nothing of the current frame is needed once the
+ * arguments are evaluated. When f takes as many arguments as the current
+ * function, all arguments are evaluated first (they may read the
+ * parameters) and then stored into our own incoming argument slots, and:
+ *  - a self call branches back to just after the prologue, reusing the
+ *    frame: the recursion becomes a loop;
+ *  - any other call pops the frame (restoring $ra if it was saved) and
+ *    jumps to f, which returns directly to our caller, who pops the same
+ *    number of arguments.
+ */
+static int isTailCall(ASTNode* node) {
+    if (!currentFunc || !node || node->type != NODE_FUNC_CALL) return 0;
+    int argCount = 0;
+    for (ASTNode* a = node->data.func_call.args; a; a = a->data.arg_list.next) argCount++;
+    return argCount == frameParams;
+}
+
+/* Returns 0 if node is not a tail call */
+static int genTailCall(ASTNode* node) {
+    if (!isTailCall(node)) return 0;
+
+    fprintf(output, "    # Tail call to %s\n", node->data.func_call.name);
+    /* Keep the values in registers when they fit, else park them in spill slots */
+    int inRegs = frameParams <= TEMP_REGS;
+    int index = 0;
+    for (ASTNode* a = node->data.func_call.args; a; a = a->data.arg_list.next) {
+        if (index + regNeed(a->data.arg_list.expr) > TEMP_REGS) inRegs = 0;
+        index++;
+    }
+    tempReg = 0;
+    for (ASTNode* a = node->data.func_call.args; a; a = a->data.arg_list.next) {
+        genExpr(a->data.arg_list.expr);
+        if (!inRegs) {
+            pushSpill(0);
+            tempReg = 0;
+        }
+    }
+    frameUsed = 1;
+    for (index = frameParams - 1; index >= 0; index--) {
+        int reg = index;
+        if (!inRegs) {
+            reg = 0;
+            popSpill(0);
+        }
+        fprintf(output, "    sw $t%d, %d($sp)\n", reg, frameSize + (frameParams - 1 - index) * 4 + spDelta);
+    }
+    tempReg = 0;
+
+    if (strcmp(node->data.func_call.name, currentFunc->data.func_decl.name) == 0) {
+        fprintf(output, "    j %s\n", entryLabel);
+        entryJumped = 1;
+    } else {
+        if (savesRa) fprintf(output, "    lw $ra, %d($sp)\n", frameSize - 4);
+        if (frameSize > 0) fprintf(output, "    addi $sp, $sp, %d\n", frameSize);
+        fprintf(output, "    j %s\n", node->data.func_call.name);
+    }
+    return 1;
+}
+
+/* Generate the body of a function into a memory buffer, returning the
+   frame size it needs */
+static int genFunctionBody(ASTNode* node, char** body, size_t* bodyLen) {
+    output = open_memstream(body, bodyLen);
+    if (!output) {
+        fprintf(stderr, "Cannot allocate code buffer\n");
+        exit(1);
+    }
+    spillBytes = 0;
+    spillTop = 0;
+    spDelta = 0;
+    retJumped = 0;
+    entryJumped = 0;
+    endsInTailCall = 0;
+    frameUsed = 0;
+    tempReg = 0;
+    /* Body (a trailing return falls through into the epilogue) */
+    genStmt(node->data.func_decl.body);
+    if (node->data.func_decl.ret) genStmt(node->data.func_decl.ret);
+    fclose(output);
+    return spillBase + spillBytes + (savesRa ? 4 : 0);
+}
+
+/* Generate one function into funcOutput with an exactly sized frame */
+static void genFunction(ASTNode* node) {
+    /* Save the enclosing (main) frame state */
+    FILE* savedOutput = output;
+    int savedSpillBase = spillBase, savedSpillBytes = spillBytes, savedSpDelta = spDelta;
+    int savedSpillTop = spillTop;
+    const char* savedRetLabel = retLabel;
+    int savedRetJumped = retJumped;
+    ASTNode* savedTailReturn = tailReturn;
+    ASTNode* savedFunc = currentFunc;
+    const char* savedEntryLabel = entryLabel;
+    int savedEntryJumped = entryJumped;
+    int savedEndsInTailCall = endsInTailCall;
+
+    char label[256], entry[256];
+    snprintf(label, sizeof(label), "%s_ret", node->data.func_decl.name);
+    snprintf(entry, sizeof(entry), "%s_entry", node->data.func_decl.name);
+    inFunction = 1;
+    retLabel = label;
+    tailReturn = node->data.func_decl.ret ? node->data.func_decl.ret
+                                          : lastStmt(node->data.func_decl.body);
+    currentFunc = node;
+    entryLabel = entry;
+    frameParams = 0;
+    for (ASTNode* p = node->data.func_decl.params; p; p = p->data.param_list.next) frameParams++;
+    /* Parameters stay in the caller's argument slots: the locals area
+       only holds the other variables of the scope */
+    frameScope = node->data.func_decl.scope;
+    spillBase = getScopeSize(frameScope) - frameParams * 4;
+    savesRa = makesCalls(node->data.func_decl.body) || makesCalls(node->data.func_decl.ret);
+
+    /* The frame size is only known once the body is generated; if the
+       body addressed the argument slots with a different guess, redo it */
+    char* body = NULL;
+    size_t bodyLen = 0;
+    frameSize = spillBase + (savesRa ? 4 : 0);
+    int frame = genFunctionBody(node, &body, &bodyLen);
+    if (frameUsed && frame != frameSize) {
+        free(body);
+        body = NULL;
+        frameSize = frame;
+        frame = genFunctionBody(node, &body, &bodyLen);
+    }
+
+    FILE* out = funcOutput;
+    fprintf(out, "\n%s:\n", node->data.func_decl.name);
+    /* Prologue: reserve the frame and save the return address if the body
+       makes calls. There is no frame pointer: the caller pushed the
+       arguments left to right, so argument i of n is at
+       frame + (n - 1 - i) * 4 off $sp. */
+    fprintf(out, "    # Frame: %d bytes (%d locals, %d spill, %d saved)\n",
+            frame, spillBase, spillBytes, savesRa ? 4 : 0);
+    if (frame > 0) fprintf(out, "    addi $sp, $sp, -%d\n", frame);
+    if (savesRa) fprintf(out, "    sw $ra, %d($sp)\n", frame - 4);
+    if (entryJumped) fprintf(out, "%s:\n", entry);
+    fwrite(body, 1, bodyLen, out);
+    free(body);
+    /* Epilogue: restore frame and return */
+    if (retJumped) fprintf(out, "%s:\n", label);
+    if (retJumped || !endsInTailCall) {
+        if (savesRa) fprintf(out, "    lw $ra, %d($sp)\n", frame - 4);
+        if (frame > 0) fprintf(out, "    addi $sp, $sp, %d\n", frame);
+        fprintf(out, "    jr $ra\n");
+    }
+
+    /* Back to the enclosing frame */
+    output = savedOutput;
+    spillBase = savedSpillBase;
+    spillBytes = savedSpillBytes;
+    spDelta = savedSpDelta;
+    spillTop = savedSpillTop;
+    retLabel = savedRetLabel;
+    retJumped = savedRetJumped;
+    tailReturn = savedTailReturn;
+    currentFunc = savedFunc;
+    entryLabel = savedEntryLabel;
+    entryJumped = savedEntryJumped;
+    endsInTailCall = savedEndsInTailCall;
+    inFunction = 0;
+    tempReg = 0;
+}
+
 void genStmt(ASTNode* node) {
     if (!node) return;
-    
+
     switch(node->type) {
-        case NODE_DECL: {
-            int offset = addVar(node->data.name);
-            if (offset == -1) {
-                fprintf(stderr, "Error: Variable %s already declared\n", node->data.name);
-                exit(1);
-            }
-            fprintf(output, "    # Declared %s at offset %d\n", node->data.name, offset);
+        case NODE_DECL:
+            fprintf(output, "    # Declared %s at offset %d\n", node->data.name,
+                    frameOffset(getSymbol(node->sym)));
             break;
-        }
-        
+
+        case NODE_ARRAY_DECL:
+            fprintf(output, "    # Declared %s[%d] at offset %d\n", node->data.array_decl.name,
+                    node->data.array_decl.size, frameOffset(getSymbol(node->sym)));
+            break;
+
         case NODE_ASSIGN: {
-            int offset = getVarOffset(node->data.assign.var);
-            if (offset == -1) {
-                fprintf(stderr, "Error: Variable %s not declared\n", node->data.assign.var);
-                exit(1);
-            }
+            Symbol* sym = getSymbol(node->sym);
             genExpr(node->data.assign.value);
-            fprintf(output, "    sw $t%d, %d($sp)\n", tempReg - 1, offset);
+            int offset;
+            const char* base = varBase(sym, &offset);
+            fprintf(output, "    sw $t%d, %d(%s)\n", tempReg - 1, offset, base);
             tempReg = 0;
             break;
         }
-        
+
+        case NODE_ARRAY_ASSIGN: {
+            Symbol* sym = getSymbol(node->sym);
+            genExpr(node->data.array_assign.index);
+            int indexReg = tempReg - 1;
+            genExpr(node->data.array_assign.value);
+            int valueReg = tempReg - 1;
+            int offset = genElementAddress(sym, indexReg);
+            fprintf(output, "    sw $t%d, %d($t%d)\n", valueReg, offset, indexReg);
+            tempReg = 0;
+            break;
+        }
+
         case NODE_PRINT:
             genExpr(node->data.expr);
             fprintf(output, "    # Print integer\n");
@@ -94,133 +608,102 @@ void genStmt(ASTNode* node) {
             fprintf(output, "    syscall\n");
             tempReg = 0;
             break;
-            
+
         case NODE_STMT_LIST:
             genStmt(node->data.stmtlist.stmt);
             genStmt(node->data.stmtlist.next);
             break;
-        case NODE_FUNC_DECL: {
-            /* Emit function label */
-            fprintf(output, "%s:\n", node->data.func_decl.name);
-            /* Enter function scope */
-            pushScope(node->data.func_decl.name);
-            /* Prologue: save return address and frame (minimal) */
-            fprintf(output, "    addi $sp, $sp, -8\n");
-            fprintf(output, "    sw $ra, 4($sp)\n");
-            fprintf(output, "    sw $fp, 0($sp)\n");
-            /* Set new frame pointer */
-            fprintf(output, "    addi $fp, $sp, 8\n");
-            /* Parameters: allocate locals and copy from caller stack into locals
-               Calling convention used by this compiler:
-                 - Caller pushes args left-to-right, so the last argument is on top
-                 - Callee sets $fp = caller's $sp (before pushing RA/FP), so
-                   at entry: argN at 0($fp), argN-1 at 4($fp), ...
-            */
-            if (node->data.func_decl.params) {
-                /* Count params */
-                int count = 0;
-                ASTNode* p = node->data.func_decl.params;
-                while (p) { count++; p = p->data.param_list.next; }
-                /* Copy into locals in declared order */
-                int index = 0;
-                p = node->data.func_decl.params;
-                while (p) {
-                    const char* pname = p->data.param_list.name;
-                    int localOff = addVar((char*)pname);
-                    /* source offset relative to $fp */
-                    int srcOff = (count - 1 - index) * 4;
-                    fprintf(output, "    lw $t%d, %d($fp)\n", getNextTemp(), srcOff);
-                    fprintf(output, "    sw $t%d, %d($sp)\n", tempReg - 1, localOff);
-                    tempReg = 0;
-                    index++;
-                    p = p->data.param_list.next;
-                }
-            }
-            /* Body */
-            genStmt(node->data.func_decl.body);
-            /* If function has return expression node, evaluate and move to $v0 */
-            if (node->data.func_decl.ret) {
-                genStmt(node->data.func_decl.ret);
-                /* return expression expects its value in $tX (tempReg-1) */
-                fprintf(output, "    move $v0, $t%d\n", tempReg - 1);
-                tempReg = 0;
-            }
-            /* Epilogue: restore frame and return */
-            fprintf(output, "    lw $fp, 0($sp)\n");
-            fprintf(output, "    lw $ra, 4($sp)\n");
-            fprintf(output, "    addi $sp, $sp, 8\n");
-            fprintf(output, "    jr $ra\n");
-            /* Exit function scope */
-            popScope();
+        case NODE_FUNC_DECL:
+            genFunction(node);
             break;
-        }
-        case NODE_FUNC_CALL: {
-            /* Evaluate arguments (minimal: no args or args evaluated into $t regs) */
-            ASTNode* a = node->data.func_call.args;
-            int argCount = 0;
-            while (a) {
-                genExpr(a->data.arg_list.expr);
-                /* Push arg to stack */
-                fprintf(output, "    addi $sp, $sp, -4\n");
-                fprintf(output, "    sw $t%d, 0($sp)\n", tempReg - 1);
-                tempReg = 0;
-                argCount++;
-                a = a->data.arg_list.next;
-            }
-            /* Call function */
-            fprintf(output, "    jal %s\n", node->data.func_call.name);
-            /* Pop arguments off stack */
-            if (argCount > 0) {
-                fprintf(output, "    addi $sp, $sp, %d\n", argCount * 4);
-            }
-            /* After call, return value is in $v0, move to temp reg */
-            fprintf(output, "    move $t%d, $v0\n", getNextTemp());
+        case NODE_FUNC_CALL:
+            genExpr(node);
+            tempReg = 0;
             break;
-        }
         case NODE_RETURN: {
+            if (genTailCall(node->data.return_expr)) {
+                if (node == tailReturn) endsInTailCall = 1;
+                break;
+            }
             /* Evaluate return expression */
             genExpr(node->data.return_expr);
-            /* Move result to $v0 and jump to epilogue by jr $ra (caller handles cleanup) */
+            /* Result goes in $v0; the frame is torn down by the epilogue */
             fprintf(output, "    move $v0, $t%d\n", tempReg - 1);
             tempReg = 0;
-            /* Return from function */
-            fprintf(output, "    jr $ra\n");
+            if (node != tailReturn) {
+                fprintf(output, "    j %s\n", retLabel);
+                retJumped = 1;
+            }
             break;
         }
-            
+
         default:
             break;
     }
 }
 
 void generateMIPS(ASTNode* root, const char* filename) {
-    output = fopen(filename, "w");
-    if (!output) {
+    FILE* file = fopen(filename, "w");
+    if (!file) {
         fprintf(stderr, "Cannot open output file %s\n", filename);
         exit(1);
     }
-    
-    // Initialize symbol table
-    initSymTab();
-    
+
+    char* mainBody = NULL;
+    size_t mainLen = 0;
+    char* funcs = NULL;
+    size_t funcsLen = 0;
+    output = open_memstream(&mainBody, &mainLen);
+    funcOutput = open_memstream(&funcs, &funcsLen);
+    if (!output || !funcOutput) {
+        fprintf(stderr, "Cannot allocate code buffer\n");
+        exit(1);
+    }
+
+    // main's frame holds the top-level (global) variables
+    spillBase = getScopeSize(0);
+    spillBytes = 0;
+    spillTop = 0;
+    spDelta = 0;
+    inFunction = 0;
+    usesGlobalBase = 0;
+    retLabel = "main_ret";
+    retJumped = 0;
+    currentFunc = NULL;
+    tempReg = 0;
+
+    // Generate code for statements; functions go to funcOutput
+    genStmt(root);
+    fclose(output);
+    fclose(funcOutput);
+    output = file;
+
+    int frame = spillBase + spillBytes;
+
     // MIPS program header
     fprintf(output, ".data\n");
     fprintf(output, "\n.text\n");
     fprintf(output, ".globl main\n");
     fprintf(output, "main:\n");
-    
-    // Allocate stack space (max 100 variables * 4 bytes)
-    fprintf(output, "    # Allocate stack space\n");
-    fprintf(output, "    addi $sp, $sp, -400\n\n");
-    
-    // Generate code for statements
-    genStmt(root);
-    
+
+    // Allocate exactly the stack space main uses
+    fprintf(output, "    # Allocate stack space (%d locals, %d spill)\n", spillBase, spillBytes);
+    if (frame > 0) fprintf(output, "    addi $sp, $sp, -%d\n", frame);
+    if (usesGlobalBase) fprintf(output, "    move $gp, $sp\n");
+    fprintf(output, "\n");
+    fwrite(mainBody, 1, mainLen, output);
+    free(mainBody);
+
     // Program exit
+    if (retJumped) fprintf(output, "%s:\n", retLabel);
     fprintf(output, "\n    # Exit program\n");
-    fprintf(output, "    addi $sp, $sp, 400\n");
+    if (frame > 0) fprintf(output, "    addi $sp, $sp, %d\n", frame);
     fprintf(output, "    li $v0, 10\n");
     fprintf(output, "    syscall\n");
-    
+
+    // Function bodies follow main so execution never falls into them
+    fwrite(funcs, 1, funcsLen, output);
+    free(funcs);
+
     fclose(output);
-}
\ No newline at end of file
+}
@@ -3,6 +3,7 @@
 
 #include "ast.h"
 
+/* Requires resolveNames(root) to have bound the tree to the symbol table */
 void generateMIPS(ASTNode* root, const char* filename);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gvn.h"
+
+/* Scoped hash table entry: chains are LIFO, so leaving a block pops its
+   entries from the front of their buckets. */
+typedef struct {
+    TACOp op;
+    TACOperand arg1;
+    TACOperand arg2;
+    TACOperand leader;  /* First value computing the expression */
+    unsigned int hash;
+    int next;           /* Next entry in the bucket, -1 at the end */
+} ScopedExpr;
+
+typedef struct {
+    SSAForm* ssa;
+    TACOperand* leader;     /* Per SSA name: value it is known to equal */
+    int* buckets;
+    int bucketCount;
+    ScopedExpr* entries;    /* Stack of live entries */
+    int entryCount;
+    int entryCapacity;
+} GVNState;
+
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in GVN\n");
+        exit(1);
+    }
+    return p;
+}
+
+static unsigned int hashOperand(TACOperand op) {
+    unsigned int h = (unsigned int)op.kind * 2654435761u;
+    if (op.kind == OPR_FLOAT) {
+        unsigned long long bits;
+        memcpy(&bits, &op.u.fval, sizeof(bits));
+        h ^= (unsigned int)(bits ^ (bits >> 32));
+    } else if (op.kind != OPR_NONE) {
+        h ^= (unsigned int)op.u.ival * 40503u;
+    }
+    return h ^ ((unsigned int)op.ver << 16);
+}
+
+static int compareOperands(TACOperand a, TACOperand b) {
+    if (a.kind != b.kind) return a.kind < b.kind ? -1 : 1;
+    if (a.kind == OPR_FLOAT) return a.u.fval < b.u.fval ? -1 : a.u.fval > b.u.fval;
+    if (a.u.ival != b.u.ival) return a.u.ival < b.u.ival ? -1 : 1;
+    return a.ver < b.ver ? -1 : a.ver > b.ver;
+}
+
+/* Value number of an operand: its leader if it is an SSA value */
+static TACOperand numbered(GVNState* st, TACOperand op) {
+    int name = ssaName(st->ssa, op);
+    return name < 0 ? op : st->leader[name];
+}
+
+/* Constants and SSA values never change; memory might */
+static int isValue(GVNState* st, TACOperand op) {
+    return op.kind == OPR_INT || op.kind == OPR_FLOAT || ssaName(st->ssa, op) >= 0;
+}
+
+static void setLeader(GVNState* st, TACOperand result, TACOperand value) {
+    int name = ssaName(st->ssa, result);
+    if (name >= 0) st->leader[name] = value;
+}
+
+/* What result = value makes result stand for; an int/float conversion
+   makes a new value unless it folds */
+static TACOperand copiedValue(GVNState* st, TACOperand value, TACOperand result) {
+    if (!isValue(st, value)) return result;
+    if (value.kind == OPR_INT || value.kind == OPR_FLOAT) return convertConstant(&value, result) ? value : result;
+    if (result.kind == OPR_SYM && isFloatOperand(value) != isFloatOperand(result)) return result;
+    return value;
+}
+
+static void numberBlock(GVNState* st, int b) {
+    SSAForm* ssa = st->ssa;
+    BasicBlock* blk = &ssa->cfg->blocks[b];
+    int mark = st->entryCount;
+
+    for (int i = blk->first; i < blk->last; i++) {
+        TACInstr* in = &ssa->fn->code[i];
+
+        if (in->op == TAC_PHI) {
+            /* A phi of one value is that value */
+            TACOperand same = numbered(st, tacProgram.phiArgs[in->arg1.u.ival]);
+            int allSame = isValue(st, same);
+            for (int a = 1; a < in->paramCount && allSame; a++)
+                allSame = sameOperand(numbered(st, tacProgram.phiArgs[in->arg1.u.ival + a]), same);
+            setLeader(st, in->result, allSame ? same : in->result);
+            continue;
+        }
+        if (in->op == TAC_NOP || in->op == TAC_CALL || in->op == TAC_DECL_ARRAY) {
+            if (in->op == TAC_CALL) setLeader(st, in->result, in->result);
+            continue;
+        }
+
+        in->arg1 = numbered(st, in->arg1);
+        in->arg2 = numbered(st, in->arg2);
+
+        if (ssaName(ssa, in->result) < 0 || !definesResult(in->op)) continue;
+        if (in->op == TAC_ASSIGN) {
+            setLeader(st, in->result, copiedValue(st, in->arg1, in->result));
+            continue;
+        }
+        if (in->op == TAC_LOAD || !isValue(st, in->arg1) || !isValue(st, in->arg2)) {
+            setLeader(st, in->result, in->result);
+            continue;
+        }
+
+        TACOperand a = in->arg1;
+        TACOperand c = in->arg2;
+        if ((in->op == TAC_ADD || in->op == TAC_MUL) && compareOperands(a, c) > 0) {
+            TACOperand t = a;
+            a = c;
+            c = t;
+        }
+        unsigned int h = ((unsigned int)in->op * 31u + hashOperand(a)) * 31u + hashOperand(c);
+        int e = st->buckets[h & (st->bucketCount - 1)];
+        while (e >= 0) {
+            ScopedExpr* x = &st->entries[e];
+            if (x->hash == h && x->op == in->op && sameOperand(x->arg1, a) && sameOperand(x->arg2, c)) break;
+            e = x->next;
+        }
+        if (e >= 0) {
+            optStats.gvnEliminated[in->op]++;
+            TACOperand leader = st->entries[e].leader;
+            *in = createTAC(TAC_ASSIGN, leader, noOperand(), in->result);
+            setLeader(st, in->result, leader);
+            continue;
+        }
+
+        if (st->entryCount >= st->entryCapacity) {
+            st->entryCapacity = st->entryCapacity ? st->entryCapacity * 2 : 64;
+            st->entries = realloc(st->entries, sizeof(ScopedExpr) * st->entryCapacity);
+            if (!st->entries) {
+                fprintf(stderr, "Out of memory in GVN\n");
+                exit(1);
+            }
+        }
+        ScopedExpr* x = &st->entries[st->entryCount];
+        x->op = in->op;
+        x->arg1 = a;
+        x->arg2 = c;
+        x->leader = in->result;
+        x->hash = h;
+        x->next = st->buckets[h & (st->bucketCount - 1)];
+        st->buckets[h & (st->bucketCount - 1)] = st->entryCount++;
+        setLeader(st, in->result, in->result);
+    }
+
+    /* Phi arguments on edges out of this block */
+    for (int s = 0; s < blk->succCount; s++) {
+        BasicBlock* succ = &ssa->cfg->blocks[blk->succs[s]];
+        int slot = 0;
+        while (succ->preds[slot] != b) slot++;
+        for (int i = succ->first; i < succ->last; i++) {
+            TACInstr* phi = &ssa->fn->code[i];
+            if (phi->op == TAC_PHI) {
+                TACOperand* arg = &tacProgram.phiArgs[phi->arg1.u.ival + slot];
+                *arg = numbered(st, *arg);
+            }
+        }
+    }
+
+    for (int c = 0; c < ssa->dom->childCount[b]; c++) numberBlock(st, ssa->dom->children[b][c]);
+
+    while (st->entryCount > mark) {
+        ScopedExpr* x = &st->entries[--st->entryCount];
+        st->buckets[x->hash & (st->bucketCount - 1)] = x->next;
+    }
+}
+
+void runGVN(SSAForm* ssa) {
+    GVNState st;
+    st.ssa = ssa;
+    inferFloatTemps(ssa->fn);
+    st.leader = xcalloc(ssa->nameCount, sizeof(TACOperand));
+    for (int n = 0; n < ssa->nameCount; n++) {
+        /* Until numbered, every value stands for itself */
+        if (ssa->nameTemp[n] >= 0) st.leader[n] = tempOperand(ssa->nameTemp[n]);
+        else {
+            int v = ssaVarOf(ssa, n);
+            st.leader[n] = symOperand(ssa->varSym[v]);
+            st.leader[n].ver = n - ssa->versionBase[v];
+        }
+    }
+    st.bucketCount = 16;
+    while (st.bucketCount < ssa->fn->count) st.bucketCount *= 2;
+    st.buckets = xcalloc(st.bucketCount, sizeof(int));
+    memset(st.buckets, -1, sizeof(int) * st.bucketCount);
+    st.entries = NULL;
+    st.entryCount = st.entryCapacity = 0;
+
+    numberBlock(&st, ssa->cfg->entry);
+    for (int b = 0; b < ssa->cfg->blockCount; b++) {
+        if (b != ssa->cfg->entry && ssa->dom->idom[b] < 0) numberBlock(&st, b);
+    }
+
+    free(st.leader);
+    free(st.buckets);
+    free(st.entries);
+    updateSSAChains(ssa);
+}
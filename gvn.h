@@ -0,0 +1,20 @@
+#ifndef GVN_H
+#define GVN_H
+
+#include "ssa.h"
+
+/* GLOBAL VALUE NUMBERING
+ * Dominator-based value numbering over a function in SSA form. Walking
+ * the dominator tree with a scoped hash table, an ADD/SUB/MUL/DIV whose
+ * operator and value-numbered operands match a computation in a
+ * dominating block (or earlier in the same block) becomes a copy of it.
+ * Copies are looked through, and a phi whose incoming values are all the
+ * same value is replaced by that value.
+ *
+ * Only expressions over SSA values and constants are numbered across
+ * blocks; anything read from memory is left to LVN, which sees every
+ * write inside its block.
+ */
+void runGVN(SSAForm* ssa);
+
+#endif
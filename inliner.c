@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "inliner.h"
+
+static int* funcOf = NULL;        /* Label id -> function index, -1 if not a function */
+static int funcOfSize = 0;
+static int* callSites = NULL;     /* Function index -> CALL instructions naming it */
+static int* bodySize = NULL;      /* Function index -> instructions inlined, -1 if not inlinable */
+static char* inlined = NULL;      /* Function index -> some call to it was inlined */
+
+static int* tempMap = NULL;       /* Callee temp -> renamed temp in the current copy */
+static int* tempStamp = NULL;     /* Copy that tempMap entry belongs to */
+static int tempMapSize = 0;
+static int copyStamp = 0;
+
+static TACInstr* out = NULL;
+static int outCount = 0, outCapacity = 0;
+
+static void* xrealloc(void* p, size_t size) {
+    p = realloc(p, size ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Out of memory in inlineCalls\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void emit(TACInstr instr) {
+    if (outCount == outCapacity) {
+        outCapacity = outCapacity ? outCapacity * 2 : 64;
+        out = xrealloc(out, sizeof(TACInstr) * outCapacity);
+    }
+    out[outCount++] = instr;
+}
+
+static int functionOf(TACOperand label) {
+    if (label.kind != OPR_LABEL || label.u.label >= funcOfSize) return -1;
+    return funcOf[label.u.label];
+}
+
+/* Map labels to functions and measure every function for the cost model */
+static void analyzeProgram() {
+    int n = tacProgram.funcCount;
+    funcOfSize = 0;
+    for (int f = 0; f < n; f++) {
+        if (tacProgram.funcs[f].name >= funcOfSize) funcOfSize = tacProgram.funcs[f].name + 1;
+    }
+    funcOf = xrealloc(funcOf, sizeof(int) * funcOfSize);
+    for (int l = 0; l < funcOfSize; l++) funcOf[l] = -1;
+    for (int f = 0; f < n; f++) funcOf[tacProgram.funcs[f].name] = f;
+
+    callSites = xrealloc(callSites, sizeof(int) * n);
+    bodySize = xrealloc(bodySize, sizeof(int) * n);
+    for (int f = 0; f < n; f++) callSites[f] = 0;
+    for (int f = 0; f < n; f++) {
+        TACFunction* fn = &tacProgram.funcs[f];
+        int size = 0;
+        int reachable = 1;
+        for (int i = 0; i < fn->count; i++) {
+            TACInstr* in = &fn->code[i];
+            if (in->op == TAC_CALL) {
+                int callee = functionOf(in->arg1);
+                if (callee >= 0) callSites[callee]++;
+                if (reachable) size = -1;
+            }
+            if (!reachable || size < 0) continue;
+            switch (in->op) {
+                case TAC_FUNC_BEGIN: case TAC_FUNC_END: case TAC_LABEL: case TAC_NOP: case TAC_DECL:
+                    break;
+                case TAC_PHI:
+                    size = -1;
+                    break;
+                case TAC_RETURN:
+                    size++;
+                    reachable = 0;
+                    break;
+                default:
+                    size++;
+                    break;
+            }
+        }
+        bodySize[f] = f == 0 ? -1 : size;
+    }
+}
+
+static int shouldInline(int callee, int argCount) {
+    if (callee <= 0 || bodySize[callee] < 0) return 0;
+    if (tacProgram.funcs[callee].paramCount != argCount) return 0;
+    return bodySize[callee] <= INLINE_MAX_SIZE ||
+           (callSites[callee] == 1 && bodySize[callee] <= INLINE_SINGLE_SITE_SIZE);
+}
+
+static TACOperand renamed(TACOperand op) {
+    if (op.kind != OPR_TEMP) return op;
+    int t = op.u.temp;
+    if (tempStamp[t] != copyStamp) {
+        tempStamp[t] = copyStamp;
+        tempMap[t] = newTemp().u.temp;
+    }
+    return tempOperand(tempMap[t]);
+}
+
+/* Copy callee's body in place of call, whose arguments are in args[] */
+static void emitBody(TACFunction* callee, TACInstr* call, int* args) {
+    for (int p = 0; p < callee->paramCount; p++) {
+        emit(createTAC(TAC_ASSIGN, tempOperand(args[p]), noOperand(), symOperand(callee->params[p])));
+    }
+
+    if (tacProgram.tempCount > tempMapSize) {
+        int old = tempMapSize;
+        tempMapSize = tacProgram.tempCount * 2;
+        tempMap = xrealloc(tempMap, sizeof(int) * tempMapSize);
+        tempStamp = xrealloc(tempStamp, sizeof(int) * tempMapSize);
+        for (int t = old; t < tempMapSize; t++) tempStamp[t] = 0;
+    }
+    copyStamp++;
+
+    TACOperand value = intOperand(0);   /* Falling off the end returns nothing useful */
+    for (int i = 0; i < callee->count; i++) {
+        TACInstr in = callee->code[i];
+        /* Scalar declarations only matter to the callee's own frame */
+        if (in.op == TAC_FUNC_BEGIN || in.op == TAC_LABEL || in.op == TAC_NOP || in.op == TAC_DECL) continue;
+        if (in.op == TAC_FUNC_END) break;
+        if (in.op == TAC_RETURN) {
+            if (in.arg1.kind != OPR_NONE) value = renamed(in.arg1);
+            break;
+        }
+        in.arg1 = renamed(in.arg1);
+        in.arg2 = renamed(in.arg2);
+        in.result = renamed(in.result);
+        emit(in);
+    }
+    emit(createTAC(TAC_ASSIGN, value, noOperand(), call->result));
+}
+
+/* Inline every qualifying call in fn; returns the number inlined */
+static int inlineInto(TACFunction* fn, int self) {
+    /* Match PARAMs to their CALL: a call takes the most recent pending ones */
+    int* pending = xrealloc(NULL, sizeof(int) * (fn->count + 1));
+    int* slot = xrealloc(NULL, sizeof(int) * (fn->count + 1));  /* PARAM: its temp; CALL: start in args */
+    int* args = xrealloc(NULL, sizeof(int) * (fn->count + 1));
+    int pendingCount = 0, argCount = 0, calls = 0;
+
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        slot[i] = -1;
+        if (in->op == TAC_PARAM) pending[pendingCount++] = i;
+        if (in->op != TAC_CALL) continue;
+        int n = in->paramCount <= pendingCount ? in->paramCount : pendingCount;
+        pendingCount -= n;
+        int callee = functionOf(in->arg1);
+        if (callee == self || n != in->paramCount || !shouldInline(callee, n)) continue;
+        slot[i] = argCount;
+        for (int p = 0; p < n; p++) {
+            int param = pending[pendingCount + p];
+            slot[param] = newTemp().u.temp;
+            args[argCount++] = slot[param];
+        }
+        calls++;
+    }
+
+    if (calls > 0) {
+        outCount = 0;
+        for (int i = 0; i < fn->count; i++) {
+            TACInstr* in = &fn->code[i];
+            if (in->op == TAC_PARAM && slot[i] >= 0) {
+                emit(createTAC(TAC_ASSIGN, in->arg1, noOperand(), tempOperand(slot[i])));
+            } else if (in->op == TAC_CALL && slot[i] >= 0) {
+                int callee = functionOf(in->arg1);
+                emitBody(&tacProgram.funcs[callee], in, &args[slot[i]]);
+                inlined[callee] = 1;
+                callSites[callee]--;
+            } else {
+                emit(*in);
+            }
+        }
+        /* Swap in the rewritten code; the old array becomes the next scratch buffer */
+        TACInstr* old = fn->code;
+        int oldCapacity = fn->capacity;
+        fn->code = out;
+        fn->count = outCount;
+        fn->capacity = outCapacity;
+        out = old;
+        outCapacity = oldCapacity;
+    }
+
+    free(pending);
+    free(slot);
+    free(args);
+    return calls;
+}
+
+/* Drop functions whose every call was inlined */
+static void removeInlinedFunctions() {
+    int kept = 1;
+    for (int f = 1; f < tacProgram.funcCount; f++) {
+        TACFunction* fn = &tacProgram.funcs[f];
+        if (inlined[f] && callSites[f] == 0) {
+            free(fn->code);
+            free(fn->params);
+            optStats.inlineRemoved++;
+            continue;
+        }
+        tacProgram.funcs[kept++] = *fn;
+    }
+    tacProgram.funcCount = kept;
+}
+
+void inlineCalls() {
+    for (int round = 0; round < INLINE_ROUNDS; round++) {
+        analyzeProgram();
+        inlined = xrealloc(inlined, tacProgram.funcCount);
+        for (int f = 0; f < tacProgram.funcCount; f++) inlined[f] = 0;
+
+        int calls = 0;
+        for (int f = 0; f < tacProgram.funcCount; f++) calls += inlineInto(&tacProgram.funcs[f], f);
+        if (calls == 0) break;
+        optStats.inlinedCalls += calls;
+        removeInlinedFunctions();
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef INLINER_H
+#define INLINER_H
+
+#include "tac.h"
+
+/* FUNCTION INLINING
+ * Replaces calls to small leaf functions (functions that make no calls
+ * themselves) with a copy of the callee's body, saving the argument
+ * pushes, jal, prologue/epilogue and parameter copies of a real call.
+ *
+ * At an inlined call site each PARAM becomes a copy of the argument into
+ * a fresh temp (arguments are evaluated where they always were), the
+ * CALL becomes copies of those temps into the callee's parameters
+ * followed by the body with every temp renamed, and the callee's RETURN
+ * value is copied into the call's result. Code after the first RETURN
+ * can never run (TAC has no branches) and is not copied.
+ *
+ * Cost model: a callee is inlined when its body is at most
+ * INLINE_MAX_SIZE instructions, or when it has a single call site and at
+ * most INLINE_SINGLE_SITE_SIZE instructions. Callers that become leaves
+ * are considered again, up to INLINE_ROUNDS times. A function left with
+ * no call sites is removed. Runs before the other passes, which then
+ * propagate constants into and clean up the inlined code.
+ */
+#define INLINE_MAX_SIZE 16
+#define INLINE_SINGLE_SITE_SIZE 200
+#define INLINE_ROUNDS 4
+
+void inlineCalls();
+
+#endif
@@ -0,0 +1,332 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ipcp.h"
+#include "symtab.h"
+
+#define MAX_GROUPS 16     /* Distinct constant combinations tracked per function */
+
+/* One edge of the call graph */
+typedef struct {
+    int caller;     /* Function index containing the CALL */
+    int call;       /* Index of the CALL instruction */
+    int callee;     /* Function index called */
+    int args;       /* Its arguments: argValues[args .. args + callee's paramCount) */
+} CallSite;
+
+static CallSite* sites = NULL;
+static int siteCount = 0, siteCapacity = 0;
+static TACOperand* argValues = NULL;   /* Constant passed per argument, OPR_NONE if unknown */
+static int argCount = 0, argCapacity = 0;
+
+static int* funcOf = NULL;             /* Label id -> function index, -1 if not a function */
+static int funcOfSize = 0;
+static int* siteStart = NULL;          /* Function -> its sites: bySite[siteStart[f] .. siteStart[f+1]) */
+static int* bySite = NULL;
+
+static TACOperand* tempValue = NULL;   /* Constant held by a temp, per current function */
+static int* tempStamp = NULL;          /* Function scan that tempValue entry belongs to */
+static int tempSize = 0;
+static int scanStamp = 0;
+
+static TACInstr* out = NULL;
+static int outCount = 0, outCapacity = 0;
+
+static void* grow(void* p, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return p;
+    int n = *capacity ? *capacity : 64;
+    while (n < needed) n *= 2;
+    p = realloc(p, n * size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in propagateConstantArgs\n");
+        exit(1);
+    }
+    *capacity = n;
+    return p;
+}
+
+static int functionOf(TACOperand label) {
+    if (label.kind != OPR_LABEL || label.u.label >= funcOfSize) return -1;
+    return funcOf[label.u.label];
+}
+
+/* Constant value of an operand at this point of the scan, OPR_NONE if unknown */
+static TACOperand constantOf(TACOperand op) {
+    if (op.kind == OPR_INT || op.kind == OPR_FLOAT) return op;
+    if (op.kind == OPR_TEMP && op.u.temp < tempSize && tempStamp[op.u.temp] == scanStamp) return tempValue[op.u.temp];
+    return noOperand();
+}
+
+/* Record what a temp-defining instruction leaves in its temp */
+static void recordTemp(TACInstr* in) {
+    int t = in->result.u.temp;
+    if (t >= tempSize) return;
+    TACOperand value = noOperand();
+    TACOperand a = constantOf(in->arg1), b = constantOf(in->arg2);
+    if (in->op == TAC_ASSIGN) {
+        value = a;
+    } else if (in->op != TAC_LOAD && in->op != TAC_CALL && in->op != TAC_PHI) {
+        int i;
+        double d;
+        if (a.kind == OPR_INT && b.kind == OPR_INT && foldInt(in->op, a.u.ival, b.u.ival, &i)) value = intOperand(i);
+        if (a.kind == OPR_FLOAT && b.kind == OPR_FLOAT && foldFloat(in->op, a.u.fval, b.u.fval, &d)) value = floatOperand(d);
+    }
+    tempStamp[t] = scanStamp;
+    tempValue[t] = value;
+}
+
+/* Can param receive value by an entry assignment? Only exact type matches */
+static int fitsParam(int param, TACOperand value) {
+    Symbol* s = getSymbol(param);
+    if (s->isArray) return 0;
+    return (value.kind == OPR_INT && s->type == TYPE_INT) || (value.kind == OPR_FLOAT && s->type == TYPE_FLOAT);
+}
+
+/* Build the call graph: every call site with its constant arguments, grouped by callee */
+static void buildCallGraph() {
+    int n = tacProgram.funcCount;
+    funcOfSize = 0;
+    for (int f = 0; f < n; f++) {
+        if (tacProgram.funcs[f].name >= funcOfSize) funcOfSize = tacProgram.funcs[f].name + 1;
+    }
+    int capacity = 0;
+    funcOf = grow(NULL, &capacity, funcOfSize, sizeof(int));
+    for (int l = 0; l < funcOfSize; l++) funcOf[l] = -1;
+    for (int f = 0; f < n; f++) funcOf[tacProgram.funcs[f].name] = f;
+
+    if (tacProgram.tempCount > tempSize) {
+        int old = tempSize;
+        tempValue = grow(tempValue, &tempSize, tacProgram.tempCount, sizeof(TACOperand));
+        tempStamp = realloc(tempStamp, sizeof(int) * tempSize);
+        if (!tempStamp) {
+            fprintf(stderr, "Out of memory in propagateConstantArgs\n");
+            exit(1);
+        }
+        for (int t = old; t < tempSize; t++) tempStamp[t] = 0;
+    }
+
+    siteCount = 0;
+    argCount = 0;
+    TACOperand* pending = NULL;
+    int pendingCount = 0, pendingCapacity = 0;
+    for (int f = 0; f < n; f++) {
+        TACFunction* fn = &tacProgram.funcs[f];
+        scanStamp++;
+        pendingCount = 0;
+        for (int i = 0; i < fn->count; i++) {
+            TACInstr* in = &fn->code[i];
+            if (in->op == TAC_PARAM) {
+                pending = grow(pending, &pendingCapacity, pendingCount + 1, sizeof(TACOperand));
+                pending[pendingCount++] = constantOf(in->arg1);
+                continue;
+            }
+            if (in->op == TAC_CALL) {
+                int given = in->paramCount <= pendingCount ? in->paramCount : pendingCount;
+                pendingCount -= given;
+                int callee = functionOf(in->arg1);
+                if (callee >= 0) {
+                    TACFunction* target = &tacProgram.funcs[callee];
+                    sites = grow(sites, &siteCapacity, siteCount + 1, sizeof(CallSite));
+                    sites[siteCount++] = (CallSite){ f, i, callee, argCount };
+                    argValues = grow(argValues, &argCapacity, argCount + target->paramCount, sizeof(TACOperand));
+                    for (int p = 0; p < target->paramCount; p++) {
+                        TACOperand value = given == in->paramCount && given == target->paramCount
+                                           ? pending[pendingCount + p] : noOperand();
+                        argValues[argCount++] = fitsParam(target->params[p], value) ? value : noOperand();
+                    }
+                }
+            }
+            if (definesResult(in->op) && in->result.kind == OPR_TEMP) recordTemp(in);
+        }
+    }
+    free(pending);
+
+    /* Counting sort of the sites by callee */
+    siteStart = realloc(siteStart, sizeof(int) * (n + 1));
+    bySite = realloc(bySite, sizeof(int) * (siteCount + 1));
+    if (!siteStart || !bySite) {
+        fprintf(stderr, "Out of memory in propagateConstantArgs\n");
+        exit(1);
+    }
+    for (int f = 0; f <= n; f++) siteStart[f] = 0;
+    for (int s = 0; s < siteCount; s++) siteStart[sites[s].callee + 1]++;
+    for (int f = 0; f < n; f++) siteStart[f + 1] += siteStart[f];
+    int* fill = calloc(n + 1, sizeof(int));
+    if (!fill) {
+        fprintf(stderr, "Out of memory in propagateConstantArgs\n");
+        exit(1);
+    }
+    for (int s = 0; s < siteCount; s++) {
+        int f = sites[s].callee;
+        bySite[siteStart[f] + fill[f]++] = s;
+    }
+    free(fill);
+    free(funcOf);
+    funcOf = NULL;
+}
+
+static int sameArgs(CallSite* a, CallSite* b, int paramCount) {
+    for (int p = 0; p < paramCount; p++) {
+        if (!sameOperand(argValues[a->args + p], argValues[b->args + p])) return 0;
+    }
+    return 1;
+}
+
+static int hasConstantArg(CallSite* site, int paramCount) {
+    for (int p = 0; p < paramCount; p++) {
+        if (argValues[site->args + p].kind != OPR_NONE) return 1;
+    }
+    return 0;
+}
+
+/* Copy function f under a new name, renaming its temps; returns the copy's index */
+static int cloneFunction(int f, int number) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s.constprop.%d", labelName(tacProgram.funcs[f].name), number);
+    int label = internLabel(name);
+    int c = addFunction(label, tacProgram.funcs[f].scope);
+    TACFunction* orig = &tacProgram.funcs[f];
+    TACFunction* copy = &tacProgram.funcs[c];
+
+    copy->paramCount = orig->paramCount;
+    copy->params = malloc(sizeof(int) * (orig->paramCount ? orig->paramCount : 1));
+    copy->code = malloc(sizeof(TACInstr) * (orig->count ? orig->count : 1));
+    if (!copy->params || !copy->code) {
+        fprintf(stderr, "Out of memory in propagateConstantArgs\n");
+        exit(1);
+    }
+    for (int p = 0; p < orig->paramCount; p++) copy->params[p] = orig->params[p];
+    copy->count = orig->count;
+    copy->capacity = orig->count;
+
+    /* Temps defined in the copy get fresh numbers (tempValue is reused as the map) */
+    scanStamp++;
+    for (int i = 0; i < orig->count; i++) {
+        TACInstr in = orig->code[i];
+        TACOperand* ops[3] = { &in.arg1, &in.arg2, &in.result };
+        for (int k = 0; k < 3; k++) {
+            if (ops[k]->kind == OPR_TEMP && ops[k]->u.temp < tempSize) {
+                int t = ops[k]->u.temp;
+                if (tempStamp[t] != scanStamp) {
+                    tempStamp[t] = scanStamp;
+                    tempValue[t] = newTemp();
+                }
+                *ops[k] = tempValue[t];
+            }
+        }
+        if ((in.op == TAC_FUNC_BEGIN || in.op == TAC_LABEL || in.op == TAC_FUNC_END) &&
+            in.result.kind == OPR_LABEL && in.result.u.label == orig->name) {
+            in.result = labelOperand(label);
+        }
+        copy->code[i] = in;
+    }
+    optStats.ipcpClones++;
+    return c;
+}
+
+/* Clone f for its most frequent constant-argument combinations; returns instructions added */
+static int specialize(int f, int budget) {
+    TACFunction* fn = &tacProgram.funcs[f];
+    int paramCount = fn->paramCount;
+    int size = fn->count;
+    if (paramCount == 0 || size > IPCP_MAX_CLONE_SIZE || size > budget) return 0;
+
+    /* Group the sites by the constants they pass */
+    int group[MAX_GROUPS], groupSize[MAX_GROUPS], groups = 0;
+    int total = siteStart[f + 1] - siteStart[f];
+    for (int k = siteStart[f]; k < siteStart[f + 1]; k++) {
+        CallSite* site = &sites[bySite[k]];
+        if (!hasConstantArg(site, paramCount)) continue;
+        int g = 0;
+        while (g < groups && !sameArgs(&sites[group[g]], site, paramCount)) g++;
+        if (g == groups) {
+            if (groups == MAX_GROUPS) continue;
+            group[groups] = bySite[k];
+            groupSize[groups++] = 0;
+        }
+        groupSize[g]++;
+    }
+
+    /* Most frequent first (stable, so ties keep source order) */
+    for (int g = 1; g < groups; g++) {
+        int s = group[g], n = groupSize[g], h = g;
+        for (; h > 0 && groupSize[h - 1] < n; h--) {
+            group[h] = group[h - 1];
+            groupSize[h] = groupSize[h - 1];
+        }
+        group[h] = s;
+        groupSize[h] = n;
+    }
+
+    int used = 0, clones = 0, remaining = total;
+    for (int g = 0; g < groups && clones < IPCP_MAX_CLONES; g++) {
+        /* The last group of callers can keep the original, specialized in place */
+        if (groupSize[g] == remaining) break;
+        if (used + size > budget) break;
+        int c = cloneFunction(f, clones++);
+        used += size;
+        remaining -= groupSize[g];
+        int label = tacProgram.funcs[c].name;
+        CallSite pattern = sites[group[g]];
+        for (int k = siteStart[f]; k < siteStart[f + 1]; k++) {
+            CallSite* site = &sites[bySite[k]];
+            if (sameArgs(site, &pattern, paramCount)) {
+                tacProgram.funcs[site->caller].code[site->call].arg1 = labelOperand(label);
+            }
+        }
+    }
+    return used;
+}
+
+static void emit(TACInstr instr) {
+    out = grow(out, &outCapacity, outCount + 1, sizeof(TACInstr));
+    out[outCount++] = instr;
+}
+
+/* Assign every parameter that all call sites agree on its constant at entry */
+static void propagateInto(int f) {
+    TACFunction* fn = &tacProgram.funcs[f];
+    int first = siteStart[f], last = siteStart[f + 1];
+    if (first == last) return;
+
+    outCount = 0;
+    int added = 0;
+    for (int i = 0; i < fn->count; i++) {
+        emit(fn->code[i]);
+        if (fn->code[i].op != TAC_LABEL || added) continue;
+        added = 1;
+        for (int p = 0; p < fn->paramCount; p++) {
+            TACOperand value = argValues[sites[bySite[first]].args + p];
+            if (value.kind == OPR_NONE) continue;
+            int k = first + 1;
+            while (k < last && sameOperand(argValues[sites[bySite[k]].args + p], value)) k++;
+            if (k < last) continue;
+            emit(createTAC(TAC_ASSIGN, value, noOperand(), symOperand(fn->params[p])));
+            optStats.ipcpConstants++;
+        }
+    }
+
+    /* Swap in the rewritten code; the old array becomes the next scratch buffer */
+    TACInstr* old = fn->code;
+    int oldCapacity = fn->capacity;
+    fn->code = out;
+    fn->count = outCount;
+    fn->capacity = outCapacity;
+    out = old;
+    outCapacity = oldCapacity;
+}
+
+void propagateConstantArgs() {
+    int programSize = 0;
+    for (int f = 0; f < tacProgram.funcCount; f++) programSize += tacProgram.funcs[f].count;
+    int budget = programSize / 100 * IPCP_GROWTH_PERCENT;
+    if (budget < IPCP_MIN_BUDGET) budget = IPCP_MIN_BUDGET;
+
+    /* Specialize the original functions; clones are appended after them */
+    buildCallGraph();
+    int originals = tacProgram.funcCount;
+    for (int f = 1; f < originals && budget > 0; f++) budget -= specialize(f, budget);
+
+    /* Propagate over the updated call graph */
+    buildCallGraph();
+    for (int f = 1; f < tacProgram.funcCount; f++) propagateInto(f);
+}
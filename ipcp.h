@@ -0,0 +1,36 @@
+#ifndef IPCP_H
+#define IPCP_H
+
+#include "tac.h"
+
+/* INTERPROCEDURAL CONSTANT PROPAGATION
+ * Builds the call graph from TAC_CALL/TAC_PARAM and records, for every
+ * call site, which arguments are constants (literals, or temps computed
+ * from literals). Two steps use it:
+ *
+ *  - Specialization: when a function's call sites pass different
+ *    constant-argument combinations, the most frequent combinations get
+ *    their own clone (named f.constprop.N) and those call sites are
+ *    redirected to it. A function is cloned only if its body is at most
+ *    IPCP_MAX_CLONE_SIZE instructions, at most IPCP_MAX_CLONES times,
+ *    and all clones together stay within the code-size budget: the
+ *    larger of IPCP_MIN_BUDGET instructions and IPCP_GROWTH_PERCENT of
+ *    the program.
+ *
+ *  - Propagation: a parameter that receives the same constant at every
+ *    call site (clones included) is assigned that constant on entry, so
+ *    SCCP and the later passes fold it through the body.
+ *
+ * The last group of call sites (and any with no constant arguments)
+ * always stays with the original, which propagation then specializes in
+ * place, so specialization never leaves an original without callers.
+ * Arguments are still passed, so calling conventions are unchanged.
+ */
+#define IPCP_MAX_CLONE_SIZE 64
+#define IPCP_MAX_CLONES 4
+#define IPCP_MIN_BUDGET 256
+#define IPCP_GROWTH_PERCENT 25
+
+void propagateConstantArgs();
+
+#endif
@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lvn.h"
+#include "symtab.h"
+
+/* An expression already computed in this block */
+typedef struct {
+    TACOp op;
+    TACOperand arg1;
+    TACOperand arg2;
+    int stamp1;         /* Write stamps of memory operands when recorded */
+    int stamp2;
+    int epoch;          /* Call epoch if an operand is a global in memory */
+    TACOperand result;  /* SSA value holding it */
+    int used;
+} ExprEntry;
+
+static int* writes = NULL;      /* Symbol id -> writes seen so far */
+static int writesSize = 0;
+static int callEpoch = 0;
+
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in LVN\n");
+        exit(1);
+    }
+    return p;
+}
+
+static unsigned int hashOperand(TACOperand op) {
+    unsigned int h = (unsigned int)op.kind * 2654435761u;
+    switch (op.kind) {
+        case OPR_FLOAT: {
+            unsigned long long bits;
+            memcpy(&bits, &op.u.fval, sizeof(bits));
+            h ^= (unsigned int)(bits ^ (bits >> 32));
+            break;
+        }
+        case OPR_NONE:
+            break;
+        default:
+            h ^= (unsigned int)op.u.ival * 40503u;
+            break;
+    }
+    return h ^ ((unsigned int)op.ver << 16);
+}
+
+/* Total order on operands, used to canonicalize commutative operations */
+static int compareOperands(TACOperand a, TACOperand b) {
+    if (a.kind != b.kind) return a.kind < b.kind ? -1 : 1;
+    if (a.kind == OPR_FLOAT) return a.u.fval < b.u.fval ? -1 : a.u.fval > b.u.fval;
+    if (a.u.ival != b.u.ival) return a.u.ival < b.u.ival ? -1 : 1;
+    return a.ver < b.ver ? -1 : a.ver > b.ver;
+}
+
+/* Is the operand a value in memory that later code may overwrite? */
+static int inMemory(SSAForm* ssa, TACOperand op) {
+    return op.kind == OPR_SYM && ssaName(ssa, op) < 0;
+}
+
+static int stampOf(SSAForm* ssa, TACOperand op) {
+    return inMemory(ssa, op) ? writes[op.u.sym] : 0;
+}
+
+static int epochOf(SSAForm* ssa, TACOperand a, TACOperand b) {
+    if (inMemory(ssa, a) && getSymbol(a.u.sym)->scope == 0) return callEpoch;
+    if (inMemory(ssa, b) && getSymbol(b.u.sym)->scope == 0) return callEpoch;
+    return 0;
+}
+
+static int isNumbered(TACOp op) {
+    return op == TAC_ADD || op == TAC_SUB || op == TAC_MUL || op == TAC_DIV || op == TAC_LOAD ||
+           op == TAC_SHL || op == TAC_SRA || op == TAC_SRL;
+}
+
+void runLVN(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    CFG* cfg = ssa->cfg;
+    if (writesSize < getSymbolCount()) {
+        writes = realloc(writes, sizeof(int) * getSymbolCount());
+        if (!writes) {
+            fprintf(stderr, "Out of memory in LVN\n");
+            exit(1);
+        }
+        memset(writes + writesSize, 0, sizeof(int) * (getSymbolCount() - writesSize));
+        writesSize = getSymbolCount();
+    }
+
+    /* Open-addressing table, at most half full, cleared between blocks */
+    int slotCount = 16;
+    while (slotCount < fn->count * 2) slotCount *= 2;
+    ExprEntry* table = xcalloc(slotCount, sizeof(ExprEntry));
+    int* usedSlots = xcalloc(fn->count, sizeof(int));
+
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* blk = &cfg->blocks[b];
+        int usedCount = 0;
+        for (int i = blk->first; i < blk->last; i++) {
+            TACInstr* in = &fn->code[i];
+
+            if (in->op == TAC_CALL) {
+                callEpoch++;
+                continue;
+            }
+            if (in->op == TAC_STORE || (in->op == TAC_ASSIGN && inMemory(ssa, in->result))) {
+                writes[in->result.u.sym]++;
+                continue;
+            }
+            if (!isNumbered(in->op) || ssaName(ssa, in->result) < 0) continue;
+
+            TACOperand a = in->arg1;
+            TACOperand c = in->arg2;
+            if ((in->op == TAC_ADD || in->op == TAC_MUL) && compareOperands(a, c) > 0) {
+                TACOperand t = a;
+                a = c;
+                c = t;
+            }
+            int stamp1 = stampOf(ssa, a);
+            int stamp2 = stampOf(ssa, c);
+            int epoch = epochOf(ssa, a, c);
+
+            unsigned int h = ((unsigned int)in->op * 31u + hashOperand(a)) * 31u + hashOperand(c);
+            int slot = h & (slotCount - 1);
+            while (table[slot].used) {
+                ExprEntry* e = &table[slot];
+                if (e->op == in->op && sameOperand(e->arg1, a) && sameOperand(e->arg2, c) &&
+                    e->stamp1 == stamp1 && e->stamp2 == stamp2 && e->epoch == epoch) break;
+                slot = (slot + 1) & (slotCount - 1);
+            }
+
+            if (table[slot].used) {
+                optStats.lvnEliminated[in->op]++;
+                *in = createTAC(TAC_ASSIGN, table[slot].result, noOperand(), in->result);
+                continue;
+            }
+            ExprEntry* e = &table[slot];
+            e->op = in->op;
+            e->arg1 = a;
+            e->arg2 = c;
+            e->stamp1 = stamp1;
+            e->stamp2 = stamp2;
+            e->epoch = epoch;
+            e->result = in->result;
+            e->used = 1;
+            usedSlots[usedCount++] = slot;
+        }
+        for (int u = 0; u < usedCount; u++) table[usedSlots[u]].used = 0;
+    }
+
+    free(table);
+    free(usedSlots);
+    updateSSAChains(ssa);
+}
@@ -0,0 +1,19 @@
+#ifndef LVN_H
+#define LVN_H
+
+#include "ssa.h"
+
+/* LOCAL VALUE NUMBERING
+ * Within each basic block, an ADD/SUB/MUL/DIV/LOAD whose operator and
+ * operands match an earlier computation in the same block becomes a copy
+ * of the earlier result. ADD and MUL operands are put in a canonical
+ * order first, so a*b and b*a match.
+ *
+ * Works on SSA form, so renamed variables and temps never change value.
+ * Operands that live in memory (escaping globals, arrays) are matched
+ * only while nothing could have written them: an assignment to the
+ * global, a store to the array, or any call.
+ */
+void runLVN(SSAForm* ssa);
+
+#endif
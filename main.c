@@ -4,10 +4,14 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "ast.h"
 #include "codegen.h"
 #include "tac.h"
 #include "symtab.h"
+#include "resolve.h"
+#include "cfg.h"
+#include "pipeline.h"
 
 int yydebug = 0; /* Bison parser debug flag (defined here for linking) */
 
@@ -15,16 +19,72 @@ extern int yyparse();
 extern FILE* yyin;
 extern ASTNode* root;
 
+static void usage(const char* prog) {
+    printf("Usage: %s [options] <input.c> <output.s>\n", prog);
+    printf("Options:\n");
+    printf("  -stats            Report symbol table and optimizer statistics\n");
+    printf("  -dump-cfg <file>  Write the control-flow graphs as Graphviz DOT\n");
+    printf("  -O0 -O1 -O2 -O3 -Os\n");
+    printf("                    Optimization level (default -O2; -O0 skips the optimizer)\n");
+    printf("  -fpass=<a,b,...>  Run exactly these TAC passes, in this order\n");
+    printf("  -fno-pass=<a,...> Leave these passes out of the pipeline\n");
+    printf("                    Passes: inline ipcp sccp algebra lvn gvn rebalance strength fold dce\n");
+    printf("  -ftime-report     Report each pass's time and instruction-count change\n");
+    printf("Example: ./minicompiler test.c output.s\n");
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        printf("Usage: %s <input.c> <output.s>\n", argv[0]);
-        printf("Example: ./minicompiler test.c output.s\n");
+    const char* inputPath = NULL;
+    const char* outputPath = NULL;
+    int showStats = 0;
+    const char* cfgPath = NULL;
+    const char* optLevel = "2";
+    const char* passList = NULL;
+    const char* droppedPasses = NULL;
+    int timeReport = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-stats") == 0) {
+            showStats = 1;
+        } else if (strcmp(argv[i], "-dump-cfg") == 0 && i + 1 < argc) {
+            cfgPath = argv[++i];
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            optLevel = argv[i] + 2;
+        } else if (strncmp(argv[i], "-fpass=", 7) == 0) {
+            passList = argv[i] + 7;
+        } else if (strncmp(argv[i], "-fno-pass=", 10) == 0) {
+            droppedPasses = argv[i] + 10;
+        } else if (strcmp(argv[i], "-ftime-report") == 0) {
+            timeReport = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else if (!outputPath) {
+            outputPath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!inputPath || !outputPath) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!setOptLevel(optLevel)) {
+        fprintf(stderr, "Error: Unknown optimization level '-O%s'\n", optLevel);
+        usage(argv[0]);
         return 1;
     }
+    if ((passList && !setPassList(passList)) || (droppedPasses && !removePasses(droppedPasses))) {
+        return 1;
+    }
+    if (timeReport) enablePassReport();
     
-    yyin = fopen(argv[1], "r");
+    yyin = fopen(inputPath, "r");
     if (!yyin) {
-        fprintf(stderr, "Error: Cannot open input file '%s'\n", argv[1]);
+        fprintf(stderr, "Error: Cannot open input file '%s'\n", inputPath);
         return 1;
     }
     
@@ -38,7 +98,7 @@ int main(int argc, char* argv[]) {
     printf("┌──────────────────────────────────────────────────────────┐\n");
     printf("│ PHASE 1: LEXICAL & SYNTAX ANALYSIS                       │\n");
     printf("├──────────────────────────────────────────────────────────┤\n");
-    printf("│ • Reading source file: %s\n", argv[1]);
+    printf("│ • Reading source file: %s\n", inputPath);
     printf("│ • Tokenizing input (scanner.l)\n");
     printf("│ • Parsing grammar rules (parser.y)\n");
     printf("│ • Building Abstract Syntax Tree\n");
@@ -57,6 +117,9 @@ int main(int argc, char* argv[]) {
         printf("└──────────────────────────────────────────────────────────┘\n");
         printAST(root, 0);
         printf("\n");
+
+        /* Bind every identifier to its symbol once; later phases use the ids */
+        resolveNames(root);
         
         /* PHASE 3: Intermediate Code */
         printf("┌──────────────────────────────────────────────────────────┐\n");
@@ -78,10 +141,16 @@ int main(int argc, char* argv[]) {
         printf("│ Applying optimizations:                                  │\n");
         printf("│ • Constant folding (evaluate compile-time expressions)   │\n");
         printf("│ • Copy propagation (replace variables with values)       │\n");
+        printf("│ • Pass pipeline: %s\n", pipelineDescription());
         printf("└──────────────────────────────────────────────────────────┘\n");
-        optimizeTAC();
+        if (pipelineLength() > 0) optimizeTAC();
+        if (timeReport) printPassReport();
         printOptimizedTAC();
         printf("\n");
+        if (cfgPath) {
+            dumpProgramCFGs(cfgPath);
+            printf("✓ Control-flow graphs written to: %s\n\n", cfgPath);
+        }
         
         /* PHASE 5: Code Generation */
         printf("┌──────────────────────────────────────────────────────────┐\n");
@@ -92,8 +161,8 @@ int main(int argc, char* argv[]) {
         printf("│ • Using $t0-$t7 for temporary values                     │\n");
         printf("│ • System calls for print operations                      │\n");
         printf("└──────────────────────────────────────────────────────────┘\n");
-    generateMIPS(root, argv[2]);
-    printf("✓ MIPS assembly code generated to: %s\n", argv[2]);
+    generateMIPS(root, outputPath);
+    printf("✓ MIPS assembly code generated to: %s\n", outputPath);
     printf("\n");
 
     /* PHASE 6: Symbol Table Snapshot */
@@ -102,8 +171,12 @@ int main(int argc, char* argv[]) {
     printf("├──────────────────────────────────────────────────────────┤\n");
     printf("│ Variables and arrays allocated on the stack:             │\n");
     printf("└──────────────────────────────────────────────────────────┘\n");
-    /* Symbol table is populated during code generation */
+    /* Symbol table was populated by name resolution after parsing */
     printSymTab();
+    if (showStats) {
+        printSymTabStats();
+        printOptimizerStats();
+    }
         
         printf("╔════════════════════════════════════════════════════════════╗\n");
         printf("║                  COMPILATION SUCCESSFUL!                   ║\n");
@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pipeline.h"
+#include "tac.h"
+#include "ssa.h"
+#include "sccp.h"
+#include "lvn.h"
+#include "gvn.h"
+#include "algebra.h"
+#include "rebalance.h"
+#include "strength.h"
+#include "inliner.h"
+#include "ipcp.h"
+
+typedef enum {
+    PASS_PROGRAM,      /* Runs once over the whole program */
+    PASS_SSA,          /* Runs on one function in SSA form */
+    PASS_FUNCTION      /* Runs on one function in normal form */
+} PassKind;
+
+/* ANALYSES
+ * Facts passes consume, cached until a pass that does not preserve them
+ * runs. The escaping-globals set is program-wide; the SSA form belongs to
+ * one function at a time (the one being optimized) and is kept alive
+ * across consecutive SSA passes. A pass that needs normal form ends it.
+ */
+#define ANALYSIS_ESCAPES 1   /* Globals some function mentions (ssa.c) */
+#define ANALYSIS_SSA     2   /* The current function's SSA form and def-use chains */
+
+typedef struct {
+    const char* name;
+    PassKind kind;
+    int preserves;                          /* ANALYSIS_* bits still valid after the pass */
+    void (*runProgram)();
+    void (*runSSA)(SSAForm* ssa);
+    void (*runFunction)(TACFunction* fn);
+} Pass;
+
+/* Only inlining moves global references into another function; the rest
+   at most remove some, which leaves the escaping set conservative */
+static const Pass passes[] = {
+    { "inline",    PASS_PROGRAM,  0,                                inlineCalls,           NULL,            NULL },
+    { "ipcp",      PASS_PROGRAM,  ANALYSIS_ESCAPES,                 propagateConstantArgs, NULL,            NULL },
+    { "sccp",      PASS_SSA,      ANALYSIS_ESCAPES | ANALYSIS_SSA,  NULL,                  runSCCP,         NULL },
+    { "algebra",   PASS_SSA,      ANALYSIS_ESCAPES | ANALYSIS_SSA,  NULL,                  simplifyAlgebra, NULL },
+    { "lvn",       PASS_SSA,      ANALYSIS_ESCAPES | ANALYSIS_SSA,  NULL,                  runLVN,          NULL },
+    { "gvn",       PASS_SSA,      ANALYSIS_ESCAPES | ANALYSIS_SSA,  NULL,                  runGVN,          NULL },
+    { "rebalance", PASS_FUNCTION, ANALYSIS_ESCAPES,                 NULL,                  NULL,            rebalanceChains },
+    { "strength",  PASS_FUNCTION, ANALYSIS_ESCAPES,                 NULL,                  NULL,            reduceStrength },
+    { "fold",      PASS_PROGRAM,  ANALYSIS_ESCAPES,                 foldConstants,         NULL,            NULL },
+    { "dce",       PASS_PROGRAM,  ANALYSIS_ESCAPES,                 eliminateDeadCode,     NULL,            NULL },
+};
+#define PASS_COUNT ((int)(sizeof(passes) / sizeof(passes[0])))
+
+/* Pass lists of the optimization levels */
+static const struct {
+    const char* level;
+    const char* list;
+} levels[] = {
+    { "0", "" },
+    { "1", "sccp,lvn,fold,dce" },
+    { "2", "inline,ipcp,sccp,algebra,lvn,gvn,rebalance,strength,fold,dce" },
+    { "3", "inline,ipcp,sccp,algebra,lvn,gvn,sccp,algebra,lvn,gvn,rebalance,strength,fold,dce" },
+    /* Size: nothing that duplicates code or expands an instruction into several */
+    { "s", "sccp,algebra,lvn,gvn,fold,dce" },
+};
+#define LEVEL_COUNT ((int)(sizeof(levels) / sizeof(levels[0])))
+
+static int pipeline[PIPELINE_MAX_PASSES];   /* Indices into passes[] */
+static int pipelineCount = -1;              /* -1 until a level or list is chosen */
+static char description[PIPELINE_MAX_PASSES * 16];
+
+/* Analysis cache */
+static int programValid = 0;        /* ANALYSIS_ESCAPES if the set is current */
+static SSAForm* ssa = NULL;         /* SSA form of function ssaFunc, if any */
+static int ssaFunc = -1;
+static long analysisBuilt[3], analysisReused[3];   /* Indexed by ANALYSIS_* bit */
+
+/* Per-pass report, one row per pipeline entry */
+typedef struct {
+    long runs;          /* Functions (or programs) it ran on */
+    double seconds;
+    long before, after; /* Live instructions it was given and left */
+} PassReport;
+
+static int reporting = 0;
+static PassReport report[PIPELINE_MAX_PASSES];
+
+static int findPass(const char* name, int length) {
+    for (int p = 0; p < PASS_COUNT; p++) {
+        if ((int)strlen(passes[p].name) == length && strncmp(passes[p].name, name, length) == 0) return p;
+    }
+    return -1;
+}
+
+/* Call visit(pass) for every name in a comma-separated list; 0 on an unknown name */
+static int forEachPass(const char* list, int (*visit)(int pass)) {
+    const char* s = list;
+    while (*s) {
+        const char* end = strchr(s, ',');
+        int length = end ? (int)(end - s) : (int)strlen(s);
+        if (length > 0) {
+            int pass = findPass(s, length);
+            if (pass < 0) {
+                fprintf(stderr, "Error: Unknown optimization pass '%.*s'\n", length, s);
+                return 0;
+            }
+            if (!visit(pass)) return 0;
+        }
+        s += length;
+        if (*s == ',') s++;
+    }
+    return 1;
+}
+
+static int appendPass(int pass) {
+    if (pipelineCount >= PIPELINE_MAX_PASSES) {
+        fprintf(stderr, "Error: More than %d optimization passes\n", PIPELINE_MAX_PASSES);
+        return 0;
+    }
+    pipeline[pipelineCount++] = pass;
+    return 1;
+}
+
+static int dropPass(int pass) {
+    int kept = 0;
+    for (int i = 0; i < pipelineCount; i++) {
+        if (pipeline[i] != pass) pipeline[kept++] = pipeline[i];
+    }
+    pipelineCount = kept;
+    return 1;
+}
+
+int setPassList(const char* list) {
+    pipelineCount = 0;
+    return forEachPass(list, appendPass);
+}
+
+int setOptLevel(const char* level) {
+    for (int l = 0; l < LEVEL_COUNT; l++) {
+        if (strcmp(levels[l].level, level) == 0) return setPassList(levels[l].list);
+    }
+    return 0;
+}
+
+static void selectDefault() {
+    if (pipelineCount < 0) setOptLevel("2");
+}
+
+int removePasses(const char* list) {
+    selectDefault();
+    return forEachPass(list, dropPass);
+}
+
+int pipelineLength() {
+    selectDefault();
+    return pipelineCount;
+}
+
+const char* pipelineDescription() {
+    selectDefault();
+    description[0] = '\0';
+    for (int i = 0; i < pipelineCount; i++) {
+        if (i > 0) strcat(description, ",");
+        strcat(description, passes[pipeline[i]].name);
+    }
+    return pipelineCount > 0 ? description : "none";
+}
+
+void enablePassReport() {
+    reporting = 1;
+}
+
+static double now() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static long liveCount(TACFunction* fn) {
+    long n = 0;
+    for (int i = 0; i < fn->count; i++) n += fn->code[i].op != TAC_NOP;
+    return n;
+}
+
+static long programSize() {
+    long n = 0;
+    for (int f = 0; f < tacProgram.funcCount; f++) n += liveCount(&tacProgram.funcs[f]);
+    return n;
+}
+
+static void useEscapes() {
+    if (programValid & ANALYSIS_ESCAPES) {
+        analysisReused[ANALYSIS_ESCAPES]++;
+        return;
+    }
+    findEscapingGlobals();
+    programValid |= ANALYSIS_ESCAPES;
+    analysisBuilt[ANALYSIS_ESCAPES]++;
+}
+
+/* SSA form of function f, built on first use */
+static SSAForm* useSSA(int f) {
+    if (ssa && ssaFunc == f) {
+        analysisReused[ANALYSIS_SSA]++;
+        return ssa;
+    }
+    useEscapes();
+    ssa = buildSSA(&tacProgram.funcs[f]);
+    ssaFunc = f;
+    analysisBuilt[ANALYSIS_SSA]++;
+    return ssa;
+}
+
+/* Back to normal form */
+static void endSSA() {
+    if (!ssa) return;
+    destroySSA(ssa);
+    ssa = NULL;
+    ssaFunc = -1;
+}
+
+/* Run pipeline entry i on function f (or the program when f < 0) */
+static void runPass(int i, int f) {
+    const Pass* pass = &passes[pipeline[i]];
+    if (pass->kind != PASS_SSA) endSSA();
+    SSAForm* form = pass->kind == PASS_SSA ? useSSA(f) : NULL;
+
+    long before = 0;
+    double start = 0;
+    if (reporting) {
+        before = f < 0 ? programSize() : liveCount(&tacProgram.funcs[f]);
+        start = now();
+    }
+
+    if (pass->kind == PASS_PROGRAM) pass->runProgram();
+    else if (pass->kind == PASS_SSA) pass->runSSA(form);
+    else pass->runFunction(&tacProgram.funcs[f]);
+
+    programValid &= pass->preserves;
+    if (!(pass->preserves & ANALYSIS_SSA)) endSSA();
+
+    if (reporting) {
+        report[i].seconds += now() - start;
+        report[i].runs++;
+        report[i].before += before;
+        report[i].after += f < 0 ? programSize() : liveCount(&tacProgram.funcs[f]);
+    }
+}
+
+void runPipeline() {
+    selectDefault();
+    int i = 0;
+    while (i < pipelineCount) {
+        if (passes[pipeline[i]].kind == PASS_PROGRAM) {
+            runPass(i++, -1);
+            continue;
+        }
+        /* Consecutive function and SSA passes run one function at a time */
+        int last = i + 1;
+        while (last < pipelineCount && passes[pipeline[last]].kind != PASS_PROGRAM) last++;
+        for (int f = 0; f < tacProgram.funcCount; f++) {
+            for (int k = i; k < last; k++) runPass(k, f);
+            endSSA();
+        }
+        i = last;
+    }
+}
+
+void printPassReport() {
+    double total = 0;
+    printf("\n=== PASS REPORT ===\n");
+    printf("%-10s %8s %11s %12s %12s %8s\n", "Pass", "Runs", "Time (ms)", "Instrs in", "Instrs out", "Delta");
+    for (int i = 0; i < pipelineCount; i++) {
+        PassReport* r = &report[i];
+        printf("%-10s %8ld %11.3f %12ld %12ld %+8ld\n", passes[pipeline[i]].name, r->runs,
+               r->seconds * 1000, r->before, r->after, r->after - r->before);
+        total += r->seconds;
+    }
+    printf("%-10s %8s %11.3f\n", "Total", "", total * 1000);
+    printf("Analyses: escaping globals built %ld, reused %ld; SSA form built %ld, reused %ld\n",
+           analysisBuilt[ANALYSIS_ESCAPES], analysisReused[ANALYSIS_ESCAPES],
+           analysisBuilt[ANALYSIS_SSA], analysisReused[ANALYSIS_SSA]);
+    printf("===================\n\n");
+}
@@ -0,0 +1,41 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/* OPTIMIZATION PIPELINE
+ * optimizeTAC runs a list of named passes in order. Each optimization
+ * level (-O0 .. -O3, -Os) selects a list; -fpass= replaces it outright
+ * and -fno-pass= drops passes from it.
+ *
+ *     inline     inline small leaf functions            (program)
+ *     ipcp       constant arguments, specialization     (program)
+ *     sccp       sparse conditional constant prop.      (SSA)
+ *     algebra    identities and reassociation           (SSA)
+ *     lvn        local value numbering                  (SSA)
+ *     gvn        global value numbering                 (SSA)
+ *     rebalance  balance long ADD/MUL chains            (function)
+ *     strength   MUL/DIV by constants to shifts         (function)
+ *     fold       constant folding, copy propagation     (program)
+ *     dce        dead-code elimination                  (program)
+ *
+ * Consecutive function and SSA passes run one function at a time. A
+ * small pass manager caches the analyses passes need (the escaping
+ * globals set, and the current function's SSA form) and each pass
+ * declares which of them it preserves, so consecutive SSA passes share
+ * one SSA construction and the escaping set is only recomputed after
+ * inlining. The default level is -O2.
+ *
+ * With the pass report enabled (-ftime-report) every pipeline entry
+ * records its wall time and the live instructions before and after it.
+ */
+#define PIPELINE_MAX_PASSES 64
+
+int setOptLevel(const char* level);     /* "0", "1", "2", "3" or "s"; 0 if unknown */
+int setPassList(const char* list);      /* Comma-separated pass names; 0 if one is unknown */
+int removePasses(const char* list);     /* Drop the named passes; 0 if one is unknown */
+const char* pipelineDescription();      /* Selected passes as "a,b,c" ("none" if empty) */
+int pipelineLength();                   /* Number of passes selected */
+void runPipeline();                     /* Run the selected passes over tacProgram */
+void enablePassReport();                /* Time passes and count their instruction deltas */
+void printPassReport();                 /* Per-pass table and analysis cache counters */
+
+#endif
@@ -0,0 +1,266 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "rebalance.h"
+#include "symtab.h"
+
+/* Per-temp facts, sized for the whole program and cleared after each function */
+typedef struct {
+    int defs;       /* Instructions writing the temp */
+    int uses;       /* Operand slots reading it */
+    int def;        /* Index of the (last) definition */
+    int user;       /* Index of the (last) use */
+    int depth;      /* Chain depth ending at the definition */
+    int leaves;     /* Chain leaves below the definition */
+} TempInfo;
+
+static TempInfo* temps = NULL;
+static int tempsSize = 0;
+
+static int* blockOf = NULL;        /* Instruction -> basic block number */
+static int blockOfSize = 0;
+
+static TACOperand* leaves = NULL;  /* Leaves of every rebalanced chain, in order */
+static int leafCount = 0, leafCapacity = 0;
+
+typedef struct {
+    int root;       /* Instruction index of the chain root */
+    int first;      /* Its leaves: leaves[first .. first + count) */
+    int count;
+} Chain;
+
+static Chain* chains = NULL;
+static int chainCount = 0, chainCapacity = 0;
+
+static TACInstr* out = NULL;
+static int outCount = 0, outCapacity = 0;
+
+static void* grow(void* p, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return p;
+    int n = *capacity ? *capacity : 64;
+    while (n < needed) n *= 2;
+    p = realloc(p, n * size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in rebalanceChains\n");
+        exit(1);
+    }
+    *capacity = n;
+    return p;
+}
+
+/* Temps created by this pass have no entry */
+static TempInfo* infoOf(TACOperand op) {
+    return op.kind == OPR_TEMP && op.u.temp < tempsSize ? &temps[op.u.temp] : NULL;
+}
+
+static void clearInfo(TACOperand op) {
+    TempInfo* t = infoOf(op);
+    if (t) *t = (TempInfo){ 0, 0, 0, 0, 0, 0 };
+}
+
+static void countUse(TACOperand op, int i) {
+    TempInfo* t = infoOf(op);
+    if (!t) return;
+    t->uses++;
+    t->user = i;
+}
+
+/* Is op a single-use temp computed by the same operator in the same block? */
+static int isLink(TACFunction* fn, TACOperand op, TACOp chainOp, int block) {
+    TempInfo* t = infoOf(op);
+    return t && t->defs == 1 && t->uses == 1 &&
+           fn->code[t->def].op == chainOp && blockOf[t->def] == block;
+}
+
+static int ceilLog2(int n) {
+    int k = 0;
+    while ((1 << k) < n) k++;
+    return k;
+}
+
+/* Does code[from..to) write op (or, for a global, call something that may)? */
+static int writtenBetween(TACFunction* fn, TACOperand op, int from, int to) {
+    if (op.kind == OPR_INT) return 0;
+    TempInfo* t = infoOf(op);
+    if (t && t->defs == 1) return 0;
+    int global = op.kind == OPR_SYM && getSymbol(op.u.sym)->scope == 0;
+    for (int i = from; i < to; i++) {
+        TACInstr* in = &fn->code[i];
+        if (in->op == TAC_CALL && global) return 1;
+        if (definesResult(in->op) && sameOperand(in->result, op)) return 1;
+    }
+    return 0;
+}
+
+/* Flatten the chain rooted at code[root] into leaves[]; 0 if it can't move */
+static int collectChain(TACFunction* fn, int root) {
+    TACInstr* in = &fn->code[root];
+    int block = blockOf[root];
+    int first = leafCount;
+    int earliest = root;
+
+    /* Depth-first, left to right, with an explicit stack of operands */
+    int stackCapacity = 0, top = 0;
+    TACOperand* stack = NULL;
+    stack = grow(stack, &stackCapacity, 2, sizeof(TACOperand));
+    stack[top++] = in->arg2;
+    stack[top++] = in->arg1;
+    while (top > 0) {
+        TACOperand op = stack[--top];
+        if (isLink(fn, op, in->op, block)) {
+            TACInstr* def = &fn->code[temps[op.u.temp].def];
+            if (temps[op.u.temp].def < earliest) earliest = temps[op.u.temp].def;
+            stack = grow(stack, &stackCapacity, top + 2, sizeof(TACOperand));
+            stack[top++] = def->arg2;
+            stack[top++] = def->arg1;
+        } else {
+            leaves = grow(leaves, &leafCapacity, leafCount + 1, sizeof(TACOperand));
+            leaves[leafCount++] = op;
+        }
+    }
+    free(stack);
+
+    for (int l = first; l < leafCount; l++) {
+        if (writtenBetween(fn, leaves[l], earliest, root)) {
+            leafCount = first;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Tombstone the links of the chain rooted at code[root] */
+static void removeLinks(TACFunction* fn, TACOperand op, TACOp chainOp, int block) {
+    while (isLink(fn, op, chainOp, block)) {
+        TACInstr* def = &fn->code[temps[op.u.temp].def];
+        removeLinks(fn, def->arg2, chainOp, block);
+        op = def->arg1;
+        def->op = TAC_NOP;
+    }
+}
+
+static void emit(TACInstr instr) {
+    out = grow(out, &outCapacity, outCount + 1, sizeof(TACInstr));
+    out[outCount++] = instr;
+}
+
+/* Balanced tree over leaves[lo..hi); the top node writes result */
+static TACOperand emitBalanced(TACOp op, int lo, int hi, TACOperand result) {
+    if (hi - lo == 1) return leaves[lo];
+    int mid = lo + (hi - lo) / 2;
+    TACOperand left = emitBalanced(op, lo, mid, noOperand());
+    TACOperand right = emitBalanced(op, mid, hi, noOperand());
+    if (result.kind == OPR_NONE) result = newTemp();
+    emit(createTAC(op, left, right, result));
+    return result;
+}
+
+/* Leave the per-temp table clean for the next function */
+static void clearTemps(TACFunction* fn) {
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        clearInfo(in->arg1);
+        clearInfo(in->arg2);
+        clearInfo(in->result);
+        if (in->op == TAC_PHI) {
+            for (int a = 0; a < in->paramCount; a++) clearInfo(tacProgram.phiArgs[in->arg1.u.ival + a]);
+        }
+    }
+}
+
+void rebalanceChains(TACFunction* fn) {
+    if (tacProgram.tempCount > tempsSize) {
+        int oldSize = tempsSize;
+        temps = grow(temps, &tempsSize, tacProgram.tempCount, sizeof(TempInfo));
+        for (int t = oldSize; t < tempsSize; t++) temps[t] = (TempInfo){ 0, 0, 0, 0, 0, 0 };
+    }
+    blockOf = grow(blockOf, &blockOfSize, fn->count, sizeof(int));
+    inferFloatTemps(fn);
+
+    /* Def/use counts and block numbers */
+    int block = 0;
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        if (in->op == TAC_LABEL) block++;
+        blockOf[i] = block;
+        if (in->op == TAC_RETURN) block++;
+        countUse(in->arg1, i);
+        countUse(in->arg2, i);
+        if (in->op == TAC_STORE) countUse(in->result, i);
+        if (in->op == TAC_PHI) {
+            for (int a = 0; a < in->paramCount; a++) countUse(tacProgram.phiArgs[in->arg1.u.ival + a], i);
+        }
+        TempInfo* t = definesResult(in->op) ? infoOf(in->result) : NULL;
+        if (t) {
+            t->defs++;
+            t->def = i;
+        }
+    }
+
+    /* Chain depth and size at every ADD/MUL; roots are those not feeding a link */
+    leafCount = 0;
+    chainCount = 0;
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        if ((in->op != TAC_ADD && in->op != TAC_MUL) || isFloatOperand(in->result)) continue;
+        int depth = 0, count = 0;
+        TACOperand args[2] = { in->arg1, in->arg2 };
+        for (int k = 0; k < 2; k++) {
+            if (isLink(fn, args[k], in->op, blockOf[i])) {
+                TempInfo* t = infoOf(args[k]);
+                if (t->depth > depth) depth = t->depth;
+                count += t->leaves;
+            } else {
+                count++;
+            }
+        }
+        depth++;
+        TempInfo* t = infoOf(in->result);
+        if (t) {
+            t->depth = depth;
+            t->leaves = count;
+            if (isLink(fn, in->result, in->op, blockOf[i]) &&
+                fn->code[t->user].op == in->op && blockOf[t->user] == blockOf[i]) continue;
+        }
+        if (count < 4 || depth <= ceilLog2(count)) continue;
+
+        int first = leafCount;
+        if (!collectChain(fn, i)) continue;
+        chains = grow(chains, &chainCapacity, chainCount + 1, sizeof(Chain));
+        chains[chainCount++] = (Chain){ i, first, leafCount - first };
+    }
+
+    if (chainCount == 0) {
+        clearTemps(fn);
+        return;
+    }
+
+    /* Drop the old links, then rebuild each root as a balanced tree */
+    for (int c = 0; c < chainCount; c++) {
+        TACInstr* root = &fn->code[chains[c].root];
+        removeLinks(fn, root->arg1, root->op, blockOf[chains[c].root]);
+        removeLinks(fn, root->arg2, root->op, blockOf[chains[c].root]);
+    }
+    outCount = 0;
+    int next = 0;
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        if (in->op == TAC_NOP) continue;
+        if (next < chainCount && chains[next].root == i) {
+            Chain* ch = &chains[next++];
+            emitBalanced(in->op, ch->first, ch->first + ch->count, in->result);
+            continue;
+        }
+        emit(*in);
+    }
+    optStats.rebalancedChains += chainCount;
+    clearTemps(fn);
+
+    /* Swap in the rewritten code; the old array becomes the next scratch buffer */
+    TACInstr* old = fn->code;
+    int oldCapacity = fn->capacity;
+    fn->code = out;
+    fn->count = outCount;
+    fn->capacity = outCapacity;
+    out = old;
+    outCapacity = oldCapacity;
+}
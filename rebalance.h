@@ -0,0 +1,20 @@
+#ifndef REBALANCE_H
+#define REBALANCE_H
+
+#include "tac.h"
+
+/* EXPRESSION REBALANCING
+ * The parser builds left-associative trees, so a + b + c + ... + z
+ * becomes a serial chain where every ADD waits for the one before it.
+ * For integer ADD and MUL (associative and commutative under wrapping
+ * arithmetic) a chain of single-use temps is flattened into its leaves
+ * and recomputed as a balanced tree at the position of the chain's
+ * root, cutting the dependency depth from n - 1 to ceil(log2 n).
+ *
+ * A chain is only rebuilt when it lies within one basic block and no
+ * variable among its leaves is written between the first link and the
+ * root. Float arithmetic is left in source order.
+ */
+void rebalanceChains(TACFunction* fn);
+
+#endif
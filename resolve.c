@@ -0,0 +1,105 @@
+/* NAME RESOLUTION (binding pass)
+ * Declares every variable in the scope it belongs to and stores the
+ * resulting symbol id in the AST, so each identifier is hashed and
+ * compared exactly once for the whole compilation.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "resolve.h"
+#include "symtab.h"
+
+static void declareNode(ASTNode* node, char* name, int type, int isArray, int size) {
+    node->sym = addSymbol(name, type, isArray, size);
+    if (node->sym == -1) {
+        fprintf(stderr, "Error: Variable %s already declared\n", name);
+        exit(1);
+    }
+}
+
+static void bindNode(ASTNode* node, char* name) {
+    node->sym = lookupSymbol(name);
+    if (node->sym == -1) {
+        fprintf(stderr, "Error: Variable %s not declared\n", name);
+        exit(1);
+    }
+}
+
+static void resolveExpr(ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_VAR:
+            bindNode(node, node->data.name);
+            break;
+        case NODE_BINOP:
+            resolveExpr(node->data.binop.left);
+            resolveExpr(node->data.binop.right);
+            break;
+        case NODE_ARRAY_ACCESS:
+            bindNode(node, node->data.array_access.name);
+            resolveExpr(node->data.array_access.index);
+            break;
+        case NODE_FUNC_CALL:
+            for (ASTNode* a = node->data.func_call.args; a; a = a->data.arg_list.next) {
+                resolveExpr(a->data.arg_list.expr);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void resolveStmt(ASTNode* node) {
+    if (!node) return;
+
+    switch (node->type) {
+        case NODE_DECL:
+            declareNode(node, node->data.name, TYPE_INT, 0, 0);
+            break;
+        case NODE_DECL_FLOAT:
+            declareNode(node, node->data.decl_float.name, TYPE_FLOAT, 0, 0);
+            break;
+        case NODE_ARRAY_DECL:
+            declareNode(node, node->data.array_decl.name, TYPE_INT, 1, node->data.array_decl.size);
+            break;
+        case NODE_ASSIGN:
+            resolveExpr(node->data.assign.value);
+            bindNode(node, node->data.assign.var);
+            break;
+        case NODE_ARRAY_ASSIGN:
+            resolveExpr(node->data.array_assign.index);
+            resolveExpr(node->data.array_assign.value);
+            bindNode(node, node->data.array_assign.name);
+            break;
+        case NODE_PRINT:
+            resolveExpr(node->data.expr);
+            break;
+        case NODE_STMT_LIST:
+            resolveStmt(node->data.stmtlist.stmt);
+            resolveStmt(node->data.stmtlist.next);
+            break;
+        case NODE_FUNC_DECL:
+            pushScope(node->data.func_decl.name);
+            node->data.func_decl.scope = getCurrentScope();
+            for (ASTNode* p = node->data.func_decl.params; p; p = p->data.param_list.next) {
+                declareNode(p, p->data.param_list.name, p->data.param_list.vtype, 0, 0);
+            }
+            resolveStmt(node->data.func_decl.body);
+            resolveStmt(node->data.func_decl.ret);
+            popScope();
+            break;
+        case NODE_FUNC_CALL:
+            resolveExpr(node);
+            break;
+        case NODE_RETURN:
+            resolveExpr(node->data.return_expr);
+            break;
+        default:
+            break;
+    }
+}
+
+void resolveNames(ASTNode* root) {
+    initSymTab();
+    resolveStmt(root);
+}
@@ -0,0 +1,15 @@
+#ifndef RESOLVE_H
+#define RESOLVE_H
+
+#include "ast.h"
+
+/* NAME RESOLUTION
+ * Walks the AST once, building the symbol table (global scope plus one
+ * scope per function) and binding every declaration and identifier use
+ * to its symbol id (ASTNode.sym). Later phases read variable metadata
+ * with getSymbol(node->sym) instead of looking names up again.
+ * Reports undeclared or redeclared variables and exits.
+ */
+void resolveNames(ASTNode* root);
+
+#endif
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "sccp.h"
+
+typedef enum {
+    LAT_UNKNOWN,        /* No evidence yet (top) */
+    LAT_CONST,          /* Always this int/float constant */
+    LAT_OVERDEFINED     /* Not a compile-time constant (bottom) */
+} LatticeKind;
+
+typedef struct {
+    LatticeKind kind;
+    TACOperand value;   /* OPR_INT / OPR_FLOAT when LAT_CONST */
+} LatticeValue;
+
+typedef struct {
+    SSAForm* ssa;
+    LatticeValue* lattice;  /* Per SSA name */
+    int* blockOf;           /* Instruction index -> block id */
+    char* blockVisited;     /* Block has been evaluated once */
+    char** edgeExec;        /* Per block, per predecessor slot: edge found executable */
+    int* flowWork;          /* Pending CFG edges as (from, to) pairs */
+    int flowCount;
+    int flowCapacity;
+    int* ssaWork;           /* SSA names whose value dropped */
+    int ssaCount;
+    int ssaCapacity;
+} SCCPState;
+
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in SCCP\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void push(int** work, int* count, int* capacity, int value) {
+    if (*count >= *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *work = realloc(*work, sizeof(int) * *capacity);
+        if (!*work) {
+            fprintf(stderr, "Out of memory in SCCP\n");
+            exit(1);
+        }
+    }
+    (*work)[(*count)++] = value;
+}
+
+static LatticeValue latticeOf(LatticeKind kind, TACOperand value) {
+    LatticeValue v;
+    v.kind = kind;
+    v.value = value;
+    return v;
+}
+
+static LatticeValue overdefined() {
+    return latticeOf(LAT_OVERDEFINED, noOperand());
+}
+
+/* Lattice value of an operand */
+static LatticeValue valueOf(SCCPState* st, TACOperand op) {
+    if (op.kind == OPR_INT || op.kind == OPR_FLOAT) return latticeOf(LAT_CONST, op);
+    int name = ssaName(st->ssa, op);
+    if (name < 0) return overdefined();     /* Memory (escaping global, array) */
+    return st->lattice[name];
+}
+
+static LatticeValue meet(LatticeValue a, LatticeValue b) {
+    if (a.kind == LAT_UNKNOWN) return b;
+    if (b.kind == LAT_UNKNOWN) return a;
+    if (a.kind == LAT_OVERDEFINED || b.kind == LAT_OVERDEFINED) return overdefined();
+    return sameOperand(a.value, b.value) ? a : overdefined();
+}
+
+/* Int or float arithmetic is chosen by the operands' types, not by the kind of constant they hold */
+static LatticeValue foldBinary(TACOp op, int isFloat, LatticeValue l, LatticeValue r) {
+    if (l.kind == LAT_OVERDEFINED || r.kind == LAT_OVERDEFINED) return overdefined();
+    if (l.kind == LAT_UNKNOWN || r.kind == LAT_UNKNOWN) return latticeOf(LAT_UNKNOWN, noOperand());
+    if (!isFloat) {
+        if (l.value.kind != OPR_INT || r.value.kind != OPR_INT) return overdefined();
+        int result;
+        if (foldInt(op, l.value.u.ival, r.value.u.ival, &result)) return latticeOf(LAT_CONST, intOperand(result));
+        return overdefined();
+    }
+    double left = l.value.kind == OPR_INT ? l.value.u.ival : l.value.u.fval;
+    double right = r.value.kind == OPR_INT ? r.value.u.ival : r.value.u.fval;
+    double result;
+    if (foldFloat(op, left, right, &result)) return latticeOf(LAT_CONST, floatOperand(result));
+    return overdefined();
+}
+
+/* Value stored into result, converted to its declared type */
+static LatticeValue convertTo(TACOperand result, LatticeValue v) {
+    if (v.kind != LAT_CONST) return v;
+    return convertConstant(&v.value, result) ? v : overdefined();
+}
+
+/* Lower a name's value; queue its uses if it changed */
+static void update(SCCPState* st, int name, LatticeValue v) {
+    LatticeValue old = st->lattice[name];
+    LatticeValue lowered = meet(old, v);
+    if (lowered.kind == old.kind && (old.kind != LAT_CONST || sameOperand(old.value, lowered.value))) return;
+    st->lattice[name] = lowered;
+    push(&st->ssaWork, &st->ssaCount, &st->ssaCapacity, name);
+}
+
+static void evaluate(SCCPState* st, int i) {
+    TACInstr* in = &st->ssa->fn->code[i];
+    if (!definesResult(in->op)) return;
+    int d = ssaName(st->ssa, in->result);
+    if (d < 0) return;
+
+    switch (in->op) {
+        case TAC_PHI: {
+            BasicBlock* blk = &st->ssa->cfg->blocks[st->blockOf[i]];
+            LatticeValue v = latticeOf(LAT_UNKNOWN, noOperand());
+            for (int a = 0; a < in->paramCount; a++) {
+                if (st->edgeExec[blk->id][a]) v = meet(v, valueOf(st, tacProgram.phiArgs[in->arg1.u.ival + a]));
+            }
+            update(st, d, v);
+            break;
+        }
+        case TAC_ASSIGN:
+            update(st, d, convertTo(in->result, valueOf(st, in->arg1)));
+            break;
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV:
+        case TAC_SHL: case TAC_SRA: case TAC_SRL: {
+            int isFloat = isFloatOperand(in->arg1) || isFloatOperand(in->arg2);
+            update(st, d, convertTo(in->result, foldBinary(in->op, isFloat, valueOf(st, in->arg1), valueOf(st, in->arg2))));
+            break;
+        }
+        default:
+            /* Loads and calls */
+            update(st, d, overdefined());
+            break;
+    }
+}
+
+static void visitBlock(SCCPState* st, int b) {
+    BasicBlock* blk = &st->ssa->cfg->blocks[b];
+    int first = !st->blockVisited[b];
+    st->blockVisited[b] = 1;
+    for (int i = blk->first; i < blk->last; i++) {
+        if (first || st->ssa->fn->code[i].op == TAC_PHI) evaluate(st, i);
+    }
+    /* No conditional branches: every successor edge is taken */
+    if (first) {
+        for (int s = 0; s < blk->succCount; s++) {
+            push(&st->flowWork, &st->flowCount, &st->flowCapacity, b);
+            push(&st->flowWork, &st->flowCount, &st->flowCapacity, blk->succs[s]);
+        }
+    }
+}
+
+/* Replace a use by its constant value, if it has one */
+static void substitute(SCCPState* st, TACOperand* op) {
+    if (op->kind != OPR_SYM && op->kind != OPR_TEMP) return;
+    LatticeValue v = valueOf(st, *op);
+    if (v.kind != LAT_CONST) return;
+    *op = v.value;
+    optStats.sccpOperands++;
+}
+
+static int isStructural(TACOp op) {
+    return op == TAC_FUNC_BEGIN || op == TAC_LABEL || op == TAC_FUNC_END ||
+           op == TAC_DECL || op == TAC_DECL_ARRAY || op == TAC_NOP;
+}
+
+void runSCCP(SSAForm* ssa) {
+    CFG* cfg = ssa->cfg;
+    TACFunction* fn = ssa->fn;
+    SCCPState st = { 0 };
+    st.ssa = ssa;
+    inferFloatTemps(fn);
+    st.lattice = xcalloc(ssa->nameCount, sizeof(LatticeValue));
+    for (int n = 0; n < ssa->nameCount; n++) {
+        /* Values on entry (parameters, uninitialized locals) are unknowable */
+        st.lattice[n] = ssa->defSite[n] < 0 ? overdefined() : latticeOf(LAT_UNKNOWN, noOperand());
+    }
+    st.blockOf = xcalloc(fn->count, sizeof(int));
+    st.blockVisited = xcalloc(cfg->blockCount, 1);
+    st.edgeExec = xcalloc(cfg->blockCount, sizeof(char*));
+    for (int b = 0; b < cfg->blockCount; b++) {
+        st.edgeExec[b] = xcalloc(cfg->blocks[b].predCount, 1);
+        for (int i = cfg->blocks[b].first; i < cfg->blocks[b].last; i++) st.blockOf[i] = b;
+    }
+
+    visitBlock(&st, cfg->entry);
+    while (st.flowCount > 0 || st.ssaCount > 0) {
+        if (st.flowCount > 0) {
+            int to = st.flowWork[--st.flowCount];
+            int from = st.flowWork[--st.flowCount];
+            BasicBlock* blk = &cfg->blocks[to];
+            int slot = 0;
+            while (blk->preds[slot] != from) slot++;
+            if (st.edgeExec[to][slot]) continue;
+            st.edgeExec[to][slot] = 1;
+            visitBlock(&st, to);
+        } else {
+            int name = st.ssaWork[--st.ssaCount];
+            for (int u = ssa->useStart[name]; u < ssa->useStart[name + 1]; u++) {
+                int i = ssa->uses[u];
+                if (st.blockVisited[st.blockOf[i]]) evaluate(&st, i);
+            }
+        }
+    }
+
+    /* Rewrite */
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* blk = &cfg->blocks[b];
+        for (int i = blk->first; i < blk->last; i++) {
+            TACInstr* in = &fn->code[i];
+            if (!st.blockVisited[b]) {
+                if (!isStructural(in->op)) {
+                    in->op = TAC_NOP;
+                    optStats.sccpUnreachable++;
+                }
+                continue;
+            }
+            if (in->op == TAC_PHI) {
+                for (int a = 0; a < in->paramCount; a++) substitute(&st, &tacProgram.phiArgs[in->arg1.u.ival + a]);
+                continue;
+            }
+            if (in->op == TAC_CALL || in->op == TAC_DECL_ARRAY) continue;
+            substitute(&st, &in->arg1);
+            substitute(&st, &in->arg2);
+
+            int d = definesResult(in->op) ? ssaName(ssa, in->result) : -1;
+            if (d >= 0 && st.lattice[d].kind == LAT_CONST && in->op != TAC_ASSIGN && in->op != TAC_CALL) {
+                *in = createTAC(TAC_ASSIGN, st.lattice[d].value, noOperand(), in->result);
+                optStats.sccpFolded++;
+            }
+        }
+    }
+    updateSSAChains(ssa);
+
+    for (int b = 0; b < cfg->blockCount; b++) free(st.edgeExec[b]);
+    free(st.edgeExec);
+    free(st.lattice);
+    free(st.blockOf);
+    free(st.blockVisited);
+    free(st.flowWork);
+    free(st.ssaWork);
+}
@@ -0,0 +1,19 @@
+#ifndef SCCP_H
+#define SCCP_H
+
+#include "ssa.h"
+
+/* SPARSE CONDITIONAL CONSTANT PROPAGATION
+ * Wegman-Zadeck over a function in SSA form. Every SSA value starts
+ * unknown and can only move down to a single int/float constant or to
+ * overdefined; values on entry, loads and call results are overdefined.
+ * Blocks are only evaluated once a CFG edge into them is found
+ * executable, so code after a return never contributes to a phi.
+ *
+ * Afterwards every use of a constant value is replaced by the constant,
+ * computations with a constant result become copies of it, and
+ * instructions in blocks that are never executed are tombstoned.
+ */
+void runSCCP(SSAForm* ssa);
+
+#endif
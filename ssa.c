@@ -0,0 +1,745 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ssa.h"
+#include "symtab.h"
+#include "bitset.h"
+
+static void* xrealloc(void* p, size_t size) {
+    p = realloc(p, size ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Out of memory in SSA\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in SSA\n");
+        exit(1);
+    }
+    return p;
+}
+
+static int* newIntArray(int count, int fill) {
+    int* a = xrealloc(NULL, sizeof(int) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) a[i] = fill;
+    return a;
+}
+
+static void appendInt(int** list, int* count, int value) {
+    *list = xrealloc(*list, sizeof(int) * (*count + 1));
+    (*list)[(*count)++] = value;
+}
+
+/* DOMINATORS */
+
+static int intersect(DomTree* dom, int a, int b) {
+    BasicBlock* blocks = dom->cfg->blocks;
+    while (a != b) {
+        while (blocks[a].rpo > blocks[b].rpo) a = dom->idom[a];
+        while (blocks[b].rpo > blocks[a].rpo) b = dom->idom[b];
+    }
+    return a;
+}
+
+static void numberTree(DomTree* dom, int b, int* counter) {
+    dom->pre[b] = (*counter)++;
+    for (int c = 0; c < dom->childCount[b]; c++) numberTree(dom, dom->children[b][c], counter);
+    dom->post[b] = (*counter)++;
+}
+
+DomTree* computeDominators(CFG* cfg) {
+    int n = cfg->blockCount;
+    DomTree* dom = xcalloc(1, sizeof(DomTree));
+    dom->cfg = cfg;
+    dom->idom = newIntArray(n, -1);
+    dom->idom[cfg->entry] = cfg->entry;
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 1; i < cfg->rpoCount; i++) {
+            BasicBlock* blk = &cfg->blocks[cfg->rpo[i]];
+            int newIdom = -1;
+            for (int p = 0; p < blk->predCount; p++) {
+                int pred = blk->preds[p];
+                if (dom->idom[pred] == -1) continue;   /* Unreachable or not processed yet */
+                newIdom = newIdom < 0 ? pred : intersect(dom, pred, newIdom);
+            }
+            if (newIdom != dom->idom[blk->id]) {
+                dom->idom[blk->id] = newIdom;
+                changed = 1;
+            }
+        }
+    }
+
+    dom->children = xcalloc(n, sizeof(int*));
+    dom->childCount = xcalloc(n, sizeof(int));
+    dom->frontier = xcalloc(n, sizeof(int*));
+    dom->frontierCount = xcalloc(n, sizeof(int));
+    for (int b = 0; b < n; b++) {
+        if (b != cfg->entry && dom->idom[b] >= 0)
+            appendInt(&dom->children[dom->idom[b]], &dom->childCount[dom->idom[b]], b);
+    }
+
+    /* Dominance frontiers: walk up from each predecessor of a join point */
+    for (int b = 0; b < n; b++) {
+        BasicBlock* blk = &cfg->blocks[b];
+        if (blk->predCount < 2 || dom->idom[b] < 0) continue;
+        for (int p = 0; p < blk->predCount; p++) {
+            int runner = blk->preds[p];
+            if (dom->idom[runner] < 0) continue;
+            while (runner != dom->idom[b]) {
+                int count = dom->frontierCount[runner];
+                if (count == 0 || dom->frontier[runner][count - 1] != b)
+                    appendInt(&dom->frontier[runner], &dom->frontierCount[runner], b);
+                runner = dom->idom[runner];
+            }
+        }
+    }
+
+    /* Interval numbering; unreachable blocks are roots of their own trees */
+    dom->pre = newIntArray(n, -1);
+    dom->post = newIntArray(n, -1);
+    int counter = 0;
+    numberTree(dom, cfg->entry, &counter);
+    for (int b = 0; b < n; b++) {
+        if (b != cfg->entry && dom->idom[b] < 0) numberTree(dom, b, &counter);
+    }
+    return dom;
+}
+
+void freeDomTree(DomTree* dom) {
+    if (!dom) return;
+    for (int b = 0; b < dom->cfg->blockCount; b++) {
+        free(dom->children[b]);
+        free(dom->frontier[b]);
+    }
+    free(dom->children);
+    free(dom->childCount);
+    free(dom->frontier);
+    free(dom->frontierCount);
+    free(dom->idom);
+    free(dom->pre);
+    free(dom->post);
+    free(dom);
+}
+
+int dominates(DomTree* dom, int a, int b) {
+    return dom->pre[a] <= dom->pre[b] && dom->post[b] <= dom->post[a];
+}
+
+/* RENAMED VARIABLES
+ * Scratch maps from symbol id / temp number to the function currently in
+ * SSA form; entries are reset when it leaves SSA form.
+ */
+static char* escapes = NULL;     /* Global mentioned by some function */
+static int escapeCount = 0;
+static int* symVar = NULL;       /* Symbol id -> variable index, -1 if not renamed */
+static int symVarSize = 0;
+static int* tempName = NULL;     /* Temp number -> SSA name, -1 if not seen */
+static int tempNameSize = 0;
+
+void findEscapingGlobals() {
+    free(escapes);
+    escapeCount = getSymbolCount();
+    escapes = xcalloc(escapeCount, 1);
+    for (int f = 1; f < tacProgram.funcCount; f++) {
+        TACFunction* fn = &tacProgram.funcs[f];
+        for (int i = 0; i < fn->count; i++) {
+            TACOperand ops[3] = { fn->code[i].arg1, fn->code[i].arg2, fn->code[i].result };
+            for (int k = 0; k < 3; k++) {
+                if (ops[k].kind == OPR_SYM && getSymbol(ops[k].u.sym)->scope == 0)
+                    escapes[ops[k].u.sym] = 1;
+            }
+        }
+    }
+}
+
+static int isRenamable(int sym) {
+    Symbol* s = getSymbol(sym);
+    if (s->isArray) return 0;
+    if (s->scope != 0) return 1;
+    return sym < escapeCount && !escapes[sym];
+}
+
+static void growMap(int** map, int* size, int needed) {
+    if (needed <= *size) return;
+    *map = xrealloc(*map, sizeof(int) * needed);
+    for (int i = *size; i < needed; i++) (*map)[i] = -1;
+    *size = needed;
+}
+
+static int varOf(TACOperand op) {
+    if (op.kind != OPR_SYM || op.u.sym >= symVarSize) return -1;
+    return symVar[op.u.sym];
+}
+
+int ssaName(SSAForm* ssa, TACOperand op) {
+    if (op.kind == OPR_SYM) {
+        int v = varOf(op);
+        return v < 0 ? -1 : ssa->versionBase[v] + op.ver;
+    }
+    if (op.kind == OPR_TEMP && op.u.temp < tempNameSize) return tempName[op.u.temp];
+    return -1;
+}
+
+int ssaVarOf(SSAForm* ssa, int name) {
+    return ssa->nameVar[name];
+}
+
+/* LIVENESS OVER BLOCKS
+ * idOf maps an operand to a dense id below size (or -1 to ignore it).
+ * Must not be used while the function contains phis.
+ */
+typedef int (*OperandId)(SSAForm* ssa, TACOperand op);
+
+static void blockLiveness(SSAForm* ssa, int size, OperandId idOf, Bitset*** liveInOut, Bitset*** liveOutOut) {
+    CFG* cfg = ssa->cfg;
+    TACInstr* code = ssa->fn->code;
+    int n = cfg->blockCount;
+    Bitset** use = xcalloc(n, sizeof(Bitset*));
+    Bitset** def = xcalloc(n, sizeof(Bitset*));
+    Bitset** liveIn = xcalloc(n, sizeof(Bitset*));
+    Bitset** liveOut = xcalloc(n, sizeof(Bitset*));
+
+    for (int b = 0; b < n; b++) {
+        use[b] = bitsetCreate(size);
+        def[b] = bitsetCreate(size);
+        liveIn[b] = bitsetCreate(size);
+        liveOut[b] = bitsetCreate(size);
+        for (int i = cfg->blocks[b].first; i < cfg->blocks[b].last; i++) {
+            TACInstr* in = &code[i];
+            if (in->op == TAC_NOP) continue;
+            TACOperand uses[3] = { in->arg1, in->arg2, in->op == TAC_STORE ? in->result : noOperand() };
+            for (int k = 0; k < 3; k++) {
+                int id = idOf(ssa, uses[k]);
+                if (id >= 0 && !bitsetContains(def[b], id)) bitsetAdd(use[b], id);
+            }
+            if (definesResult(in->op)) {
+                int id = idOf(ssa, in->result);
+                if (id >= 0) bitsetAdd(def[b], id);
+            }
+        }
+    }
+
+    Bitset* scratch = bitsetCreate(size);
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = n - 1; b >= 0; b--) {
+            BasicBlock* blk = &cfg->blocks[b];
+            for (int s = 0; s < blk->succCount; s++) bitsetUnion(liveOut[b], liveIn[blk->succs[s]]);
+            bitsetCopy(scratch, liveOut[b]);
+            bitsetSubtract(scratch, def[b]);
+            bitsetUnion(scratch, use[b]);
+            if (bitsetUnion(liveIn[b], scratch)) changed = 1;
+        }
+    }
+    bitsetFree(scratch);
+
+    for (int b = 0; b < n; b++) {
+        bitsetFree(use[b]);
+        bitsetFree(def[b]);
+    }
+    free(use);
+    free(def);
+    *liveInOut = liveIn;
+    *liveOutOut = liveOut;
+}
+
+static void freeBitsets(Bitset** sets, int count) {
+    for (int i = 0; i < count; i++) bitsetFree(sets[i]);
+    free(sets);
+}
+
+static int varIndexOf(SSAForm* ssa, TACOperand op) {
+    return varOf(op);
+}
+
+/* PHI PLACEMENT */
+
+/* Instructions that open a block ahead of any phis */
+static int isBlockPrefix(TACOp op) {
+    return op == TAC_FUNC_BEGIN || op == TAC_LABEL;
+}
+
+static void placePhis(SSAForm* ssa) {
+    CFG* cfg = ssa->cfg;
+    TACFunction* fn = ssa->fn;
+    int n = cfg->blockCount;
+    int vars = ssa->varCount;
+
+    /* Blocks defining each variable */
+    int** defBlocks = xcalloc(vars, sizeof(int*));
+    int* defBlockCount = xcalloc(vars, sizeof(int));
+    for (int b = 0; b < n; b++) {
+        for (int i = cfg->blocks[b].first; i < cfg->blocks[b].last; i++) {
+            if (!definesResult(fn->code[i].op)) continue;
+            int v = varOf(fn->code[i].result);
+            if (v < 0) continue;
+            if (defBlockCount[v] == 0 || defBlocks[v][defBlockCount[v] - 1] != b)
+                appendInt(&defBlocks[v], &defBlockCount[v], b);
+        }
+    }
+
+    Bitset** liveIn;
+    Bitset** liveOut;
+    blockLiveness(ssa, vars, varIndexOf, &liveIn, &liveOut);
+
+    /* Iterated dominance frontier, pruned by liveness */
+    int** blockPhis = xcalloc(n, sizeof(int*));
+    int* blockPhiCount = xcalloc(n, sizeof(int));
+    int* placed = newIntArray(n, -1);
+    int* queued = newIntArray(n, -1);
+    int* work = xrealloc(NULL, sizeof(int) * n);
+    int total = 0;
+    for (int v = 0; v < vars; v++) {
+        int workCount = 0;
+        for (int d = 0; d < defBlockCount[v]; d++) {
+            queued[defBlocks[v][d]] = v;
+            work[workCount++] = defBlocks[v][d];
+        }
+        while (workCount > 0) {
+            int x = work[--workCount];
+            for (int f = 0; f < ssa->dom->frontierCount[x]; f++) {
+                int y = ssa->dom->frontier[x][f];
+                if (placed[y] == v) continue;
+                placed[y] = v;
+                if (y == cfg->exit || !bitsetContains(liveIn[y], v)) continue;
+                appendInt(&blockPhis[y], &blockPhiCount[y], v);
+                total++;
+                if (queued[y] != v) {
+                    queued[y] = v;
+                    work[workCount++] = y;
+                }
+            }
+        }
+    }
+
+    /* Rebuild the instruction array with the phis at the top of their blocks */
+    if (total > 0) {
+        TACInstr* code = xrealloc(NULL, sizeof(TACInstr) * (fn->count + total));
+        int out = 0;
+        for (int b = 0; b < n; b++) {
+            BasicBlock* blk = &cfg->blocks[b];
+            int i = blk->first;
+            while (i < blk->last && isBlockPrefix(fn->code[i].op)) code[out++] = fn->code[i++];
+            for (int p = 0; p < blockPhiCount[b]; p++) {
+                TACOperand var = symOperand(ssa->varSym[blockPhis[b][p]]);
+                TACInstr phi = createTAC(TAC_PHI, intOperand(newPhiArgs(blk->predCount)), noOperand(), var);
+                phi.paramCount = blk->predCount;
+                for (int a = 0; a < blk->predCount; a++) tacProgram.phiArgs[phi.arg1.u.ival + a] = var;
+                code[out++] = phi;
+            }
+            while (i < blk->last) code[out++] = fn->code[i++];
+        }
+        free(fn->code);
+        fn->code = code;
+        fn->count = out;
+        fn->capacity = out;
+
+        freeDomTree(ssa->dom);
+        freeCFG(ssa->cfg);
+        ssa->cfg = buildCFG(fn);
+        ssa->dom = computeDominators(ssa->cfg);
+    }
+    ssa->phiCount = total;
+
+    for (int v = 0; v < vars; v++) free(defBlocks[v]);
+    for (int b = 0; b < n; b++) free(blockPhis[b]);
+    free(defBlocks);
+    free(defBlockCount);
+    free(blockPhis);
+    free(blockPhiCount);
+    free(placed);
+    free(queued);
+    free(work);
+    freeBitsets(liveIn, n);
+    freeBitsets(liveOut, n);
+}
+
+/* RENAMING
+ * Walk the dominator tree keeping a stack of live versions per variable.
+ */
+typedef struct {
+    int** stack;        /* Per variable: versions, innermost last */
+    int* depth;
+    int* capacity;
+    int* log;           /* Variables pushed, to pop on the way back up */
+    int logCount;
+    int logCapacity;
+} RenameState;
+
+static int currentVersion(RenameState* st, int v) {
+    return st->depth[v] ? st->stack[v][st->depth[v] - 1] : 0;
+}
+
+static int pushVersion(SSAForm* ssa, RenameState* st, int v) {
+    int ver = ssa->versionCount[v]++;
+    if (st->depth[v] >= st->capacity[v]) {
+        st->capacity[v] = st->capacity[v] ? st->capacity[v] * 2 : 4;
+        st->stack[v] = xrealloc(st->stack[v], sizeof(int) * st->capacity[v]);
+    }
+    st->stack[v][st->depth[v]++] = ver;
+    if (st->logCount >= st->logCapacity) {
+        st->logCapacity = st->logCapacity ? st->logCapacity * 2 : 64;
+        st->log = xrealloc(st->log, sizeof(int) * st->logCapacity);
+    }
+    st->log[st->logCount++] = v;
+    return ver;
+}
+
+static void renameUse(RenameState* st, TACOperand* op) {
+    int v = varOf(*op);
+    if (v >= 0) op->ver = currentVersion(st, v);
+}
+
+static void renameBlock(SSAForm* ssa, RenameState* st, int b) {
+    CFG* cfg = ssa->cfg;
+    TACInstr* code = ssa->fn->code;
+    BasicBlock* blk = &cfg->blocks[b];
+    int mark = st->logCount;
+
+    for (int i = blk->first; i < blk->last; i++) {
+        TACInstr* in = &code[i];
+        if (in->op == TAC_NOP || in->op == TAC_DECL) continue;
+        if (in->op != TAC_PHI) {
+            renameUse(st, &in->arg1);
+            renameUse(st, &in->arg2);
+            if (in->op == TAC_STORE) renameUse(st, &in->result);
+        }
+        if (definesResult(in->op)) {
+            int v = varOf(in->result);
+            if (v >= 0) in->result.ver = pushVersion(ssa, st, v);
+        }
+    }
+
+    /* Fill in this block's slot of every successor phi */
+    for (int s = 0; s < blk->succCount; s++) {
+        BasicBlock* succ = &cfg->blocks[blk->succs[s]];
+        int slot = 0;
+        while (succ->preds[slot] != b) slot++;
+        for (int i = succ->first; i < succ->last; i++) {
+            if (isBlockPrefix(code[i].op)) continue;
+            if (code[i].op != TAC_PHI) break;
+            renameUse(st, &tacProgram.phiArgs[code[i].arg1.u.ival + slot]);
+        }
+    }
+
+    for (int c = 0; c < ssa->dom->childCount[b]; c++) renameBlock(ssa, st, ssa->dom->children[b][c]);
+
+    while (st->logCount > mark) st->depth[st->log[--st->logCount]]--;
+}
+
+static void renameVariables(SSAForm* ssa) {
+    RenameState st;
+    st.stack = xcalloc(ssa->varCount, sizeof(int*));
+    st.depth = xcalloc(ssa->varCount, sizeof(int));
+    st.capacity = xcalloc(ssa->varCount, sizeof(int));
+    st.log = NULL;
+    st.logCount = st.logCapacity = 0;
+
+    renameBlock(ssa, &st, ssa->cfg->entry);
+    for (int b = 0; b < ssa->cfg->blockCount; b++) {
+        if (b != ssa->cfg->entry && ssa->dom->idom[b] < 0) renameBlock(ssa, &st, b);
+    }
+
+    for (int v = 0; v < ssa->varCount; v++) free(st.stack[v]);
+    free(st.stack);
+    free(st.depth);
+    free(st.capacity);
+    free(st.log);
+}
+
+/* SSA NAMES AND DEF-USE CHAINS */
+
+static void noteTemp(SSAForm* ssa, TACOperand op, int* tempCount, int** temps) {
+    if (op.kind != OPR_TEMP || tempName[op.u.temp] >= 0) return;
+    tempName[op.u.temp] = *tempCount;
+    appendInt(temps, tempCount, op.u.temp);
+}
+
+/* Visit every SSA name used by instruction i: count (fill == 0) or record it */
+static void visitUses(SSAForm* ssa, int i, int* next, int fill) {
+    TACInstr* in = &ssa->fn->code[i];
+    int names[3];
+    int count = 0;
+    if (in->op == TAC_PHI) {
+        for (int a = 0; a < in->paramCount; a++) {
+            int name = ssaName(ssa, tacProgram.phiArgs[in->arg1.u.ival + a]);
+            if (name < 0) continue;
+            if (fill) ssa->uses[next[name]++] = i;
+            else ssa->useStart[name + 1]++;
+        }
+        return;
+    }
+    names[count++] = ssaName(ssa, in->arg1);
+    names[count++] = ssaName(ssa, in->arg2);
+    if (in->op == TAC_STORE) names[count++] = ssaName(ssa, in->result);
+    for (int k = 0; k < count; k++) {
+        if (names[k] < 0) continue;
+        if (fill) ssa->uses[next[names[k]]++] = i;
+        else ssa->useStart[names[k] + 1]++;
+    }
+}
+
+static void numberNames(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    ssa->versionBase = xrealloc(NULL, sizeof(int) * (ssa->varCount + 1));
+    int names = 0;
+    for (int v = 0; v < ssa->varCount; v++) {
+        ssa->versionBase[v] = names;
+        names += ssa->versionCount[v];
+    }
+    int varNames = names;
+
+    /* Temps get names after every variable version */
+    growMap(&tempName, &tempNameSize, tacProgram.tempCount);
+    int* temps = NULL;
+    int tempCount = 0;
+    for (int i = 0; i < fn->count; i++) {
+        noteTemp(ssa, fn->code[i].arg1, &tempCount, &temps);
+        noteTemp(ssa, fn->code[i].arg2, &tempCount, &temps);
+        noteTemp(ssa, fn->code[i].result, &tempCount, &temps);
+    }
+    for (int t = 0; t < tempCount; t++) tempName[temps[t]] += varNames;
+    ssa->nameCount = varNames + tempCount;
+
+    ssa->nameTemp = newIntArray(ssa->nameCount, -1);
+    ssa->nameVar = newIntArray(ssa->nameCount, -1);
+    for (int v = 0; v < ssa->varCount; v++) {
+        for (int ver = 0; ver < ssa->versionCount[v]; ver++) ssa->nameVar[ssa->versionBase[v] + ver] = v;
+    }
+    for (int t = 0; t < tempCount; t++) ssa->nameTemp[varNames + t] = temps[t];
+    free(temps);
+
+    updateSSAChains(ssa);
+}
+
+void updateSSAChains(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    free(ssa->defSite);
+    free(ssa->useStart);
+    free(ssa->uses);
+    ssa->defSite = newIntArray(ssa->nameCount, -1);
+    ssa->useStart = xcalloc(ssa->nameCount + 1, sizeof(int));
+    for (int i = 0; i < fn->count; i++) {
+        if (fn->code[i].op == TAC_NOP) continue;
+        if (definesResult(fn->code[i].op)) {
+            int d = ssaName(ssa, fn->code[i].result);
+            if (d >= 0) ssa->defSite[d] = i;
+        }
+        visitUses(ssa, i, NULL, 0);
+    }
+    for (int n = 0; n < ssa->nameCount; n++) ssa->useStart[n + 1] += ssa->useStart[n];
+    ssa->uses = xrealloc(NULL, sizeof(int) * ssa->useStart[ssa->nameCount]);
+    int* next = xrealloc(NULL, sizeof(int) * (ssa->nameCount + 1));
+    memcpy(next, ssa->useStart, sizeof(int) * (ssa->nameCount + 1));
+    for (int i = 0; i < fn->count; i++) {
+        if (fn->code[i].op != TAC_NOP) visitUses(ssa, i, next, 1);
+    }
+    free(next);
+}
+
+SSAForm* buildSSA(TACFunction* fn) {
+    SSAForm* ssa = xcalloc(1, sizeof(SSAForm));
+    ssa->fn = fn;
+    if (!escapes) findEscapingGlobals();
+    growMap(&symVar, &symVarSize, getSymbolCount());
+
+    /* Variables to rename, in order of first mention */
+    for (int i = 0; i < fn->count; i++) {
+        TACOperand ops[3] = { fn->code[i].arg1, fn->code[i].arg2, fn->code[i].result };
+        for (int k = 0; k < 3; k++) {
+            if (ops[k].kind != OPR_SYM || symVar[ops[k].u.sym] >= 0 || !isRenamable(ops[k].u.sym)) continue;
+            symVar[ops[k].u.sym] = ssa->varCount;
+            appendInt(&ssa->varSym, &ssa->varCount, ops[k].u.sym);
+        }
+    }
+    ssa->versionCount = xrealloc(NULL, sizeof(int) * (ssa->varCount + 1));
+    for (int v = 0; v < ssa->varCount; v++) ssa->versionCount[v] = 1;
+
+    ssa->cfg = buildCFG(fn);
+    ssa->dom = computeDominators(ssa->cfg);
+    if (ssa->varCount > 0) {
+        placePhis(ssa);
+        renameVariables(ssa);
+    }
+    numberNames(ssa);
+    return ssa;
+}
+
+/* OUT OF SSA */
+
+/* Append the copies that implement block b's edge into the phis of succ */
+static void emitPhiCopies(SSAForm* ssa, int b, BasicBlock* succ, TACInstr* oldCode,
+                          TACInstr** code, int* count, int* capacity) {
+    int slot = 0;
+    while (succ->preds[slot] != b) slot++;
+
+    int phis = 0;
+    for (int i = succ->first; i < succ->last; i++) {
+        if (oldCode[i].op == TAC_PHI) phis++;
+        else if (!isBlockPrefix(oldCode[i].op) && oldCode[i].op != TAC_NOP) break;
+    }
+    if (phis == 0) return;
+
+    /* Several phis read each other's targets in parallel: go through temps */
+    TACOperand* staged = xrealloc(NULL, sizeof(TACOperand) * phis);
+    for (int pass = (phis > 1 ? 0 : 1); pass < 2; pass++) {
+        int p = 0;
+        for (int i = succ->first; i < succ->last && p < phis; i++) {
+            if (oldCode[i].op != TAC_PHI) continue;
+            TACOperand arg = tacProgram.phiArgs[oldCode[i].arg1.u.ival + slot];
+            if (*count + 1 > *capacity) {
+                *capacity = *capacity ? *capacity * 2 : 32;
+                *code = xrealloc(*code, sizeof(TACInstr) * *capacity);
+            }
+            if (phis > 1 && pass == 0) {
+                staged[p] = newTemp();
+                (*code)[(*count)++] = createTAC(TAC_ASSIGN, arg, noOperand(), staged[p]);
+            } else {
+                TACOperand src = phis > 1 ? staged[p] : arg;
+                (*code)[(*count)++] = createTAC(TAC_ASSIGN, src, noOperand(), oldCode[i].result);
+            }
+            p++;
+        }
+    }
+    free(staged);
+}
+
+static void lowerPhis(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    CFG* cfg = ssa->cfg;
+    int capacity = fn->count + 16;
+    int count = 0;
+    TACInstr* code = xrealloc(NULL, sizeof(TACInstr) * capacity);
+
+    for (int b = 0; b < cfg->blockCount; b++) {
+        BasicBlock* blk = &cfg->blocks[b];
+        for (int i = blk->first; i < blk->last; i++) {
+            if (fn->code[i].op == TAC_PHI) continue;
+            if (count + 1 > capacity) {
+                capacity *= 2;
+                code = xrealloc(code, sizeof(TACInstr) * capacity);
+            }
+            code[count++] = fn->code[i];
+        }
+        for (int s = 0; s < blk->succCount; s++)
+            emitPhiCopies(ssa, b, &cfg->blocks[blk->succs[s]], fn->code, &code, &count, &capacity);
+    }
+
+    free(fn->code);
+    fn->code = code;
+    fn->count = count;
+    fn->capacity = capacity;
+    freeDomTree(ssa->dom);
+    freeCFG(ssa->cfg);
+    ssa->dom = NULL;
+    ssa->cfg = buildCFG(fn);
+}
+
+/* SSA name of a variable version; temps are not coalesced */
+static int versionName(SSAForm* ssa, TACOperand op) {
+    return op.kind == OPR_SYM ? ssaName(ssa, op) : -1;
+}
+
+void destroySSA(SSAForm* ssa) {
+    TACFunction* fn = ssa->fn;
+    if (ssa->phiCount > 0) lowerPhis(ssa);
+
+    /* A version keeps the variable's own name unless another version of the
+       same variable is live where it is written; those get a fresh temp. */
+    int varNames = ssa->varCount ? ssa->versionBase[ssa->varCount - 1] + ssa->versionCount[ssa->varCount - 1] : 0;
+    char* conflict = xcalloc(varNames, 1);
+    if (varNames > 0) {
+        Bitset** liveIn;
+        Bitset** liveOut;
+        blockLiveness(ssa, varNames, versionName, &liveIn, &liveOut);
+        Bitset* live = bitsetCreate(varNames);
+        int* liveCount = xcalloc(ssa->varCount, sizeof(int));
+
+        for (int b = 0; b < ssa->cfg->blockCount; b++) {
+            BasicBlock* blk = &ssa->cfg->blocks[b];
+            bitsetCopy(live, liveOut[b]);
+            memset(liveCount, 0, sizeof(int) * ssa->varCount);
+            for (int n = 0; n < varNames; n++) {
+                if (bitsetContains(live, n)) liveCount[ssa->nameVar[n]]++;
+            }
+            for (int i = blk->last - 1; i >= blk->first; i--) {
+                TACInstr* in = &fn->code[i];
+                if (in->op == TAC_NOP) continue;
+                int d = definesResult(in->op) ? versionName(ssa, in->result) : -1;
+                if (d >= 0) {
+                    int v = ssa->nameVar[d];
+                    int others = liveCount[v] - bitsetContains(live, d);
+                    int src = in->op == TAC_ASSIGN ? versionName(ssa, in->arg1) : -1;
+                    if (src >= 0 && src != d && ssa->nameVar[src] == v && bitsetContains(live, src)) others--;
+                    if (others > 0) conflict[d] = 1;
+                    if (bitsetContains(live, d)) {
+                        bitsetRemove(live, d);
+                        liveCount[v]--;
+                    }
+                }
+                TACOperand uses[3] = { in->arg1, in->arg2, in->op == TAC_STORE ? in->result : noOperand() };
+                for (int k = 0; k < 3; k++) {
+                    int u = versionName(ssa, uses[k]);
+                    if (u >= 0 && !bitsetContains(live, u)) {
+                        bitsetAdd(live, u);
+                        liveCount[ssa->nameVar[u]]++;
+                    }
+                }
+            }
+        }
+
+        bitsetFree(live);
+        free(liveCount);
+        freeBitsets(liveIn, ssa->cfg->blockCount);
+        freeBitsets(liveOut, ssa->cfg->blockCount);
+    }
+
+    /* Drop versions; conflicting versions become temps */
+    int* tempFor = newIntArray(varNames ? varNames : 1, -1);
+    for (int i = 0; i < fn->count; i++) {
+        TACOperand* ops[3] = { &fn->code[i].arg1, &fn->code[i].arg2, &fn->code[i].result };
+        for (int k = 0; k < 3; k++) {
+            int n = versionName(ssa, *ops[k]);
+            if (n < 0) continue;
+            if (conflict[n]) {
+                if (tempFor[n] < 0) tempFor[n] = newTemp().u.temp;
+                *ops[k] = tempOperand(tempFor[n]);
+            } else {
+                ops[k]->ver = 0;
+            }
+        }
+        /* Copies between coalesced versions are now x = x */
+        if (fn->code[i].op == TAC_ASSIGN && fn->code[i].arg1.kind == OPR_SYM &&
+            sameOperand(fn->code[i].arg1, fn->code[i].result))
+            fn->code[i].op = TAC_NOP;
+    }
+    free(tempFor);
+    free(conflict);
+    compactTAC(fn);
+
+    /* Reset the scratch maps for the next function */
+    for (int v = 0; v < ssa->varCount; v++) symVar[ssa->varSym[v]] = -1;
+    for (int n = 0; n < ssa->nameCount; n++) {
+        if (ssa->nameTemp[n] >= 0) tempName[ssa->nameTemp[n]] = -1;
+    }
+
+    freeDomTree(ssa->dom);
+    freeCFG(ssa->cfg);
+    free(ssa->varSym);
+    free(ssa->versionCount);
+    free(ssa->versionBase);
+    free(ssa->nameTemp);
+    free(ssa->nameVar);
+    free(ssa->defSite);
+    free(ssa->useStart);
+    free(ssa->uses);
+    free(ssa);
+}
@@ -0,0 +1,69 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "tac.h"
+#include "cfg.h"
+
+/* DOMINATOR TREE
+ * Immediate dominators are computed with the Cooper-Harvey-Kennedy
+ * iterative algorithm over the CFG's reverse post-order. Unreachable
+ * blocks have no dominator (idom -1) and are roots of their own trees.
+ */
+typedef struct {
+    CFG* cfg;
+    int* idom;           /* Immediate dominator per block; entry is its own, -1 if unreachable */
+    int** children;      /* Dominator tree children per block */
+    int* childCount;
+    int** frontier;      /* Dominance frontier per block */
+    int* frontierCount;
+    int* pre;            /* Dominator tree pre-order number (for dominates()) */
+    int* post;           /* Dominator tree post-order number */
+} DomTree;
+
+DomTree* computeDominators(CFG* cfg);
+void freeDomTree(DomTree* dom);
+int dominates(DomTree* dom, int a, int b);     /* Does block a dominate block b? */
+
+/* STATIC SINGLE ASSIGNMENT FORM
+ * buildSSA rewrites one function in place so every renamed variable has
+ * exactly one definition: each definition gets a new version (operand
+ * ver), uses refer to the reaching version, and TAC_PHI instructions
+ * merge versions where control flow joins (pruned: only where the
+ * variable is live). Version 0 is the value on entry (parameters).
+ *
+ * Renamed variables are the function's scalars. Globals are only renamed
+ * in main and only when no function mentions them; every other global is
+ * treated as memory that calls may read or write.
+ *
+ * Every SSA value (a version of a renamed variable, or a temp) has a dense
+ * name with its definition site and def-use chain. Passes may rewrite
+ * operands and tombstone instructions while in SSA form; destroySSA then
+ * translates back (phis become copies, versions are coalesced onto the
+ * original variable unless their live ranges overlap) and compacts.
+ * Only one function may be in SSA form at a time.
+ */
+typedef struct {
+    TACFunction* fn;
+    CFG* cfg;
+    DomTree* dom;
+    int varCount;        /* Renamed variables */
+    int* varSym;         /* Variable index -> symbol id */
+    int* versionCount;   /* Variable index -> number of versions (including 0) */
+    int* versionBase;    /* Variable index -> SSA name of version 0 */
+    int nameCount;       /* SSA names: all variable versions, then temps */
+    int* nameTemp;       /* SSA name -> temp number (-1 for variable versions) */
+    int* nameVar;        /* SSA name -> variable index (-1 for temps) */
+    int* defSite;        /* SSA name -> defining instruction index, -1 if defined on entry */
+    int* useStart;       /* Def-use chains: uses[useStart[n] .. useStart[n+1]) */
+    int* uses;           /* Instruction indices using each name */
+    int phiCount;        /* Phi instructions inserted */
+} SSAForm;
+
+void findEscapingGlobals();                    /* Must run before buildSSA once per program */
+SSAForm* buildSSA(TACFunction* fn);            /* Rewrite fn into SSA form */
+void destroySSA(SSAForm* ssa);                 /* Translate out of SSA, compact and free */
+int ssaName(SSAForm* ssa, TACOperand op);      /* SSA name of an operand, -1 if not an SSA value */
+int ssaVarOf(SSAForm* ssa, int name);          /* Variable index of a name, -1 for temps */
+void updateSSAChains(SSAForm* ssa);            /* Recompute def sites and def-use chains after rewriting */
+
+#endif
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "strength.h"
+#include "symtab.h"
+
+/* Cost model, in single-cycle ALU instructions. mult + mflo waits on the
+ * HI/LO multiplier, which takes several times as long as a shift or add,
+ * so a shift/add sequence up to MULT_COST instructions is never slower.
+ * Division is far slower still and is always replaced when possible.
+ */
+#define MULT_COST 4
+
+/* k if value == 2^k, else -1 */
+static int exactLog2(unsigned int value) {
+    if (value == 0 || (value & (value - 1))) return -1;
+    int k = 0;
+    while (value >>= 1) k++;
+    return k;
+}
+
+int planMultiply(int multiplier, MulPlan* plan) {
+    if (multiplier == 0 || multiplier == 1 || multiplier == -1 || multiplier == INT_MIN) return 0;
+    plan->negate = multiplier < 0;
+    unsigned int c = plan->negate ? (unsigned int)-multiplier : (unsigned int)multiplier;
+
+    /* Non-adjacent form, lowest digit first: the fewest nonzero digits */
+    int shift[MAX_SHIFT_TERMS + 1], sign[MAX_SHIFT_TERMS + 1], digits = 0;
+    long long rest = c;
+    for (int k = 0; rest != 0; k++, rest >>= 1) {
+        if (rest & 1) {
+            int d = (rest & 3) == 3 ? -1 : 1;
+            shift[digits] = k;
+            sign[digits++] = d;
+            rest -= d;
+        }
+    }
+    if (digits > MAX_SHIFT_TERMS) return 0;
+
+    int cost = plan->negate + digits - 1;
+    for (int i = 0; i < digits; i++) cost += shift[i] > 0;
+    if (cost > MULT_COST) return 0;
+
+    plan->count = digits;
+    for (int i = 0; i < digits; i++) {
+        plan->shift[i] = shift[digits - 1 - i];
+        plan->sign[i] = sign[digits - 1 - i];
+    }
+    return 1;
+}
+
+int planDivide(int divisor, int* shift, int* negate) {
+    if (divisor == INT_MIN) return 0;
+    *negate = divisor < 0;
+    int k = exactLog2(*negate ? (unsigned int)-divisor : (unsigned int)divisor);
+    if (k < 1) return 0;
+    *shift = k;
+    return 1;
+}
+
+/* Signed magic number for |d| >= 2 (Hacker's Delight, figure 10-1): M is
+   about 2^p / |d| for the smallest p >= 32 that keeps the rounding error
+   below one quotient step for every 32-bit dividend; s = p - 32 */
+int planMagicDivide(int divisor, DivPlan* plan) {
+    if (divisor == 0 || divisor == 1 || divisor == -1 || divisor == INT_MIN) return 0;
+    const unsigned int two31 = 0x80000000u;
+    unsigned int ad = divisor < 0 ? (unsigned int)-divisor : (unsigned int)divisor;
+    unsigned int t = two31 + ((unsigned int)divisor >> 31);
+    unsigned int anc = t - 1 - t % ad;        /* |nc| */
+    unsigned int q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned int q2 = two31 / ad, r2 = two31 - q2 * ad;
+    unsigned int delta;
+    int p = 31;
+    do {
+        p++;
+        q1 *= 2; r1 *= 2;
+        if (r1 >= anc) { q1++; r1 -= anc; }
+        q2 *= 2; r2 *= 2;
+        if (r2 >= ad) { q2++; r2 -= ad; }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    unsigned int magic = q2 + 1;
+    plan->magic = (int)(divisor < 0 ? 0u - magic : magic);
+    plan->shift = p - 32;
+    /* M wrapped past the sign bit: the product is off by x * 2^32 */
+    plan->addDividend = divisor > 0 && plan->magic < 0 ? 1 : divisor < 0 && plan->magic > 0 ? -1 : 0;
+    return 1;
+}
+
+static int isIntValue(TACOperand op) {
+    return (op.kind == OPR_TEMP || op.kind == OPR_SYM) && !isFloatOperand(op);
+}
+
+/* EMISSION */
+static TACInstr* out;
+static int outCount, outCapacity;
+
+static void emit(TACOp op, TACOperand arg1, TACOperand arg2, TACOperand result) {
+    if (outCount == outCapacity) {
+        outCapacity = outCapacity ? outCapacity * 2 : 64;
+        out = realloc(out, sizeof(TACInstr) * outCapacity);
+        if (!out) {
+            fprintf(stderr, "Out of memory in reduceStrength\n");
+            exit(1);
+        }
+    }
+    out[outCount++] = createTAC(op, arg1, arg2, result);
+}
+
+/* result = x * multiplier as shifts and adds */
+static void emitMultiply(TACOperand x, MulPlan* plan, TACOperand result) {
+    TACOperand sum = plan->negate || plan->count > 1 ? newTemp() : result;
+    if (plan->shift[0] > 0) emit(TAC_SHL, x, intOperand(plan->shift[0]), sum);
+    else emit(TAC_ASSIGN, x, noOperand(), sum);
+
+    for (int i = 1; i < plan->count; i++) {
+        TACOperand term = x;
+        if (plan->shift[i] > 0) {
+            term = newTemp();
+            emit(TAC_SHL, x, intOperand(plan->shift[i]), term);
+        }
+        TACOperand next = plan->negate || i < plan->count - 1 ? newTemp() : result;
+        emit(plan->sign[i] > 0 ? TAC_ADD : TAC_SUB, sum, term, next);
+        sum = next;
+    }
+    if (plan->negate) emit(TAC_SUB, intOperand(0), sum, result);
+}
+
+/* result = x / 2^k (negated for a negative divisor), rounding toward zero */
+static void emitDivide(TACOperand x, int k, int negate, TACOperand result) {
+    TACOperand bias = newTemp();
+    if (k == 1) {
+        emit(TAC_SRL, x, intOperand(31), bias);
+    } else {
+        TACOperand sign = newTemp();
+        emit(TAC_SRA, x, intOperand(31), sign);
+        emit(TAC_SRL, sign, intOperand(32 - k), bias);
+    }
+    TACOperand biased = newTemp();
+    emit(TAC_ADD, x, bias, biased);
+    if (negate) {
+        TACOperand quotient = newTemp();
+        emit(TAC_SRA, biased, intOperand(k), quotient);
+        emit(TAC_SUB, intOperand(0), quotient, result);
+    } else {
+        emit(TAC_SRA, biased, intOperand(k), result);
+    }
+}
+
+void reduceStrength(TACFunction* fn) {
+    outCount = 0;
+    int replaced = 0;
+    inferFloatTemps(fn);    /* Temps created here are ints */
+
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        int intResult = in->result.kind == OPR_TEMP || in->result.kind == OPR_SYM ? !isFloatOperand(in->result) : 0;
+        if (in->op == TAC_MUL && intResult) {
+            TACOperand x = in->arg1, c = in->arg2;
+            if (x.kind == OPR_INT) {
+                x = in->arg2;
+                c = in->arg1;
+            }
+            MulPlan plan;
+            if (c.kind == OPR_INT && isIntValue(x) && planMultiply(c.u.ival, &plan)) {
+                emitMultiply(x, &plan, in->result);
+                optStats.strengthMul++;
+                replaced = 1;
+                continue;
+            }
+        } else if (in->op == TAC_DIV && intResult) {
+            int k, negate;
+            if (in->arg2.kind == OPR_INT && isIntValue(in->arg1) && planDivide(in->arg2.u.ival, &k, &negate)) {
+                emitDivide(in->arg1, k, negate, in->result);
+                optStats.strengthDiv++;
+                replaced = 1;
+                continue;
+            }
+        }
+        emit(in->op, in->arg1, in->arg2, in->result);
+        out[outCount - 1].paramCount = in->paramCount;
+    }
+    if (!replaced) return;
+
+    /* Swap in the rewritten code; the old array becomes the next scratch buffer */
+    TACInstr* old = fn->code;
+    int oldCapacity = fn->capacity;
+    fn->code = out;
+    fn->count = outCount;
+    fn->capacity = outCapacity;
+    out = old;
+    outCapacity = oldCapacity;
+}
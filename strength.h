@@ -0,0 +1,47 @@
+#ifndef STRENGTH_H
+#define STRENGTH_H
+
+#include "tac.h"
+
+/* STRENGTH REDUCTION
+ * Integer multiplication and division by constants are replaced with
+ * shifts and adds where that is cheaper than mult/div + mflo:
+ *
+ *   x * 2^k          ->  x << k
+ *   x * c            ->  sum of (x << k) terms, c in canonical signed-digit
+ *                        form, when the sequence fits the cost model
+ *   x / 2^k          ->  (x + ((x >> 31) >>> (32 - k))) >> k
+ *                        (the bias rounds negative dividends toward zero)
+ *   x / d            ->  q = hi32(x * M) (+/- x) >> s;  q + (q >>> 31)
+ *                        with the magic number M and shift s chosen so the
+ *                        result equals truncating division for every x
+ *                        (Granlund-Montgomery; code generator only, as
+ *                        TAC has no multiply-high)
+ *
+ * Negative constants negate the result afterwards. Multipliers 0, 1 and
+ * -1 and divisor 1 are left to the algebraic simplifier.
+ *
+ * The plans are shared by the TAC pass and the MIPS code generator so
+ * both emit the same sequences.
+ */
+#define MAX_SHIFT_TERMS 32
+
+typedef struct {
+    int count;                   /* Terms, highest power first */
+    int shift[MAX_SHIFT_TERMS];  /* x << shift[i] */
+    int sign[MAX_SHIFT_TERMS];   /* +1 or -1; the first term is always +1 */
+    int negate;                  /* Negate the sum (negative multiplier) */
+} MulPlan;
+
+typedef struct {
+    int magic;                   /* M: multiplier whose high word approximates x / d */
+    int shift;                   /* s: arithmetic shift applied to the high word */
+    int addDividend;             /* +1 add x, -1 subtract x after mfhi, 0 neither */
+} DivPlan;
+
+int planMultiply(int multiplier, MulPlan* plan);          /* 1 if x * multiplier should be shifts/adds */
+int planDivide(int divisor, int* shift, int* negate);     /* 1 if x / divisor should be shifts */
+int planMagicDivide(int divisor, DivPlan* plan);          /* 1 if x / divisor should be mult-high */
+void reduceStrength(TACFunction* fn);                     /* Rewrite MUL/DIV by constants in fn */
+
+#endif
@@ -1,7 +1,11 @@
 /* SYMBOL TABLE IMPLEMENTATION (scope-aware, hash-table backed)
  * Maintains a stack of scopes (global + per-function). Each scope
- * has its own hash table. Offsets are allocated from a single
- * global counter for simplicity of code generation.
+ * has its own hash table, which starts small and doubles as symbols
+ * are declared into it. Offsets are allocated per scope: every
+ * function scope starts at offset 0, so its size is exactly the
+ * locals area of that function's stack frame.
+ * Symbol data lives once, in the growable symtab.vars vector; the
+ * per-scope hash chains only store indices into it.
  */
 
 #include <stdio.h>
@@ -9,58 +13,133 @@
 #include <string.h>
 #include "symtab.h"
 
-#define HASH_SIZE 257
+#define INITIAL_BUCKETS 8   /* per-scope table size; always a power of two */
 
 typedef struct SymNode {
-    char* name;
-    int offset;
-    int isArray;
-    int arraySize;
-    struct SymNode* next;
+    int id;                    /* index into symtab.vars */
+    unsigned int hash;         /* full hash of the name, kept for rehashing */
+    struct SymNode* next;      /* next node in the same bucket */
+    struct SymNode* nextDecl;  /* next symbol declared in the same scope */
 } SymNode;
 
 typedef struct ScopeFrame {
     const char* name;          /* e.g., "global" or function name */
-    SymNode* buckets[HASH_SIZE];
+    SymNode** buckets;
+    int bucketCount;
+    int index;                 /* position in scopeList (0 = global) */
+    int size;                  /* symbols declared in this scope */
+    int nextOffset;            /* next free byte in this scope's frame */
+    SymNode* firstDecl;        /* declaration order, for printing */
+    SymNode* lastDecl;
     struct ScopeFrame* parent; /* enclosing scope */
 } ScopeFrame;
 
-/* Flat stats for compatibility/printing; offset counter is global */
+/* All symbols (flat, in declaration order) */
 static SymbolTable symtab;
 static ScopeFrame* current = NULL;  /* top of scope stack */
 
+/* INSTRUMENTATION
+ * Counters for evaluating table sizing and the hash function on real
+ * inputs; reported by printSymTabStats (-stats).
+ */
+#define PROBE_BINS 6            /* histogram bins: 0, 1, 2, 3, 4-7, 8+ */
+static struct {
+    long inserts;               /* symbols added */
+    long duplicates;            /* rejected re-declarations */
+    long lookups;               /* name resolutions through the scope chain */
+    long misses;                /* lookups that found nothing */
+    long parentWalks;           /* lookups that had to leave the innermost scope */
+    long scopeProbes;           /* single-scope hash probes (lookups + insert checks) */
+    long chainSteps;            /* chain nodes visited over all probes */
+    long strcmps;               /* name comparisons */
+    long rehashes;              /* bucket array doublings */
+    long probeHist[PROBE_BINS]; /* chain nodes visited per probe */
+} stats;
+
+static int probeBin(int n) {
+    if (n < 4) return n;
+    return n < 8 ? 4 : 5;
+}
+
 /* Keep a list of scopes for printing (in creation order) */
-static ScopeFrame scopePool[128];
-static int scopeUsed = 0;
-static ScopeFrame* scopeList[128];
+static ScopeFrame** scopeList = NULL;
 static int scopeCount = 0;
+static int scopeCapacity = 0;
 
 /* djb2 string hash */
 static unsigned int hash(const char* s) {
     unsigned long h = 5381;
     int c;
     while ((c = *s++)) h = ((h << 5) + h) + (unsigned char)c;
-    return (unsigned int)(h % HASH_SIZE);
+    return (unsigned int)h;
 }
 
-static ScopeFrame* newScope(const char* name, ScopeFrame* parent) {
-    if (scopeUsed >= (int)(sizeof(scopePool)/sizeof(scopePool[0]))) {
-        fprintf(stderr, "Scope pool exhausted\n");
+static void* xcalloc(size_t count, size_t size) {
+    void* p = calloc(count, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in symbol table\n");
         exit(1);
     }
-    ScopeFrame* s = &scopePool[scopeUsed++];
+    return p;
+}
+
+static ScopeFrame* newScope(const char* name, ScopeFrame* parent) {
+    if (scopeCount >= scopeCapacity) {
+        scopeCapacity = scopeCapacity ? scopeCapacity * 2 : 16;
+        scopeList = realloc(scopeList, sizeof(ScopeFrame*) * scopeCapacity);
+        if (!scopeList) {
+            fprintf(stderr, "Out of memory in symbol table\n");
+            exit(1);
+        }
+    }
+    ScopeFrame* s = xcalloc(1, sizeof(ScopeFrame));
     s->name = name;
     s->parent = parent;
-    for (int i = 0; i < HASH_SIZE; i++) s->buckets[i] = NULL;
-    if (scopeCount < (int)(sizeof(scopeList)/sizeof(scopeList[0]))) scopeList[scopeCount++] = s;
+    s->index = scopeCount;
+    s->bucketCount = INITIAL_BUCKETS;
+    s->buckets = xcalloc(s->bucketCount, sizeof(SymNode*));
+    scopeList[scopeCount++] = s;
     return s;
 }
 
+static void freeScope(ScopeFrame* s) {
+    for (int b = 0; b < s->bucketCount; b++) {
+        SymNode* n = s->buckets[b];
+        while (n) {
+            SymNode* next = n->next;
+            free(n);
+            n = next;
+        }
+    }
+    free(s->buckets);
+    free(s);
+}
+
+/* Double the bucket array once the scope holds as many symbols as buckets */
+static void growScope(ScopeFrame* s) {
+    int newCount = s->bucketCount * 2;
+    SymNode** grown = xcalloc(newCount, sizeof(SymNode*));
+    for (int b = 0; b < s->bucketCount; b++) {
+        SymNode* n = s->buckets[b];
+        while (n) {
+            SymNode* next = n->next;
+            unsigned int h = n->hash & (newCount - 1);
+            n->next = grown[h];
+            grown[h] = n;
+            n = next;
+        }
+    }
+    free(s->buckets);
+    s->buckets = grown;
+    s->bucketCount = newCount;
+    stats.rehashes++;
+}
+
 void initSymTab() {
+    for (int i = 0; i < scopeCount; i++) freeScope(scopeList[i]);
     symtab.count = 0;
-    symtab.nextOffset = 0;
-    scopeUsed = 0;
     scopeCount = 0;
+    memset(&stats, 0, sizeof(stats));
     current = newScope("global", NULL);
 }
 
@@ -73,92 +152,166 @@ void popScope() {
     if (current && current->parent) current = current->parent;
 }
 
-static SymNode* lookupIn(ScopeFrame* s, const char* name) {
-    unsigned int h = hash(name);
+static int lookupIn(ScopeFrame* s, const char* name) {
+    unsigned int h = hash(name) & (s->bucketCount - 1);
+    int steps = 0;
+    int id = -1;
     for (SymNode* n = s->buckets[h]; n; n = n->next) {
-        if (strcmp(n->name, name) == 0) return n;
+        steps++;
+        stats.strcmps++;
+        if (strcmp(symtab.vars[n->id].name, name) == 0) {
+            id = n->id;
+            break;
+        }
     }
-    return NULL;
+    stats.scopeProbes++;
+    stats.chainSteps += steps;
+    stats.probeHist[probeBin(steps)]++;
+    return id;
 }
 
-static SymNode* lookup(const char* name) {
+static int lookup(const char* name) {
+    stats.lookups++;
     for (ScopeFrame* s = current; s; s = s->parent) {
-        SymNode* n = lookupIn(s, name);
-        if (n) return n;
+        if (s == current->parent) stats.parentWalks++;
+        int id = lookupIn(s, name);
+        if (id >= 0) return id;
     }
-    return NULL;
+    stats.misses++;
+    return -1;
 }
 
-int addVar(char* name) {
+/* Append a symbol to the current scope, growing the vector as needed.
+   Returns its id, or -1 if the name is already declared in this scope. */
+int addSymbol(char* name, int type, int isArray, int arraySize) {
     if (!current) initSymTab();
-    if (lookupIn(current, name)) return -1; /* duplicate in current scope */
+    if (lookupIn(current, name) >= 0) { /* duplicate in current scope */
+        stats.duplicates++;
+        return -1;
+    }
+    if (symtab.count >= symtab.capacity) {
+        int newCapacity = symtab.capacity ? symtab.capacity * 2 : 64;
+        Symbol* grown = realloc(symtab.vars, sizeof(Symbol) * newCapacity);
+        if (!grown) {
+            fprintf(stderr, "Out of memory in symbol table\n");
+            exit(1);
+        }
+        symtab.vars = grown;
+        symtab.capacity = newCapacity;
+    }
+    if (current->size >= current->bucketCount) growScope(current);
     SymNode* n = (SymNode*)malloc(sizeof(SymNode));
     if (!n) return -1;
-    n->name = strdup(name);
-    n->offset = symtab.nextOffset;
-    n->isArray = 0;
-    n->arraySize = 0;
-    unsigned int h = hash(name);
+    Symbol* sym = &symtab.vars[symtab.count];
+    sym->name = strdup(name);
+    sym->offset = current->nextOffset;
+    sym->isArray = isArray;
+    sym->arraySize = arraySize;
+    sym->type = type;
+    sym->scope = current->index;
+    n->id = symtab.count++;
+    n->hash = hash(name);
+    unsigned int h = n->hash & (current->bucketCount - 1);
     n->next = current->buckets[h];
     current->buckets[h] = n;
-    if (symtab.count < MAX_VARS) {
-        symtab.vars[symtab.count].name = n->name;
-        symtab.vars[symtab.count].offset = n->offset;
-        symtab.vars[symtab.count].isArray = n->isArray;
-        symtab.vars[symtab.count].arraySize = n->arraySize;
-    }
-    symtab.count++;
-    symtab.nextOffset += 4; /* 4 bytes per int */
-    return n->offset;
+    current->size++;
+    n->nextDecl = NULL;
+    if (current->lastDecl) current->lastDecl->nextDecl = n;
+    else current->firstDecl = n;
+    current->lastDecl = n;
+    current->nextOffset += (isArray ? arraySize : 1) * 4; /* 4 bytes per int */
+    stats.inserts++;
+    return n->id;
+}
+
+int addVar(char* name) {
+    int id = addSymbol(name, 0, 0, 0);
+    return id >= 0 ? symtab.vars[id].offset : -1;
 }
 
 int addArray(char* name, int size) {
-    if (!current) initSymTab();
-    if (lookupIn(current, name)) return -1;
-    SymNode* n = (SymNode*)malloc(sizeof(SymNode));
-    if (!n) return -1;
-    n->name = strdup(name);
-    n->offset = symtab.nextOffset;
-    n->isArray = 1;
-    n->arraySize = size;
-    unsigned int h = hash(name);
-    n->next = current->buckets[h];
-    current->buckets[h] = n;
-    if (symtab.count < MAX_VARS) {
-        symtab.vars[symtab.count].name = n->name;
-        symtab.vars[symtab.count].offset = n->offset;
-        symtab.vars[symtab.count].isArray = n->isArray;
-        symtab.vars[symtab.count].arraySize = n->arraySize;
-    }
-    symtab.count++;
-    symtab.nextOffset += size * 4;
-    return n->offset;
+    int id = addSymbol(name, 0, 1, size);
+    return id >= 0 ? symtab.vars[id].offset : -1;
+}
+
+int lookupSymbol(char* name) {
+    return lookup(name);
+}
+
+Symbol* getSymbol(int id) {
+    return &symtab.vars[id];
+}
+
+int getSymbolCount() {
+    return symtab.count;
+}
+
+int getCurrentScope() {
+    return current ? current->index : 0;
+}
+
+int getScopeSize(int scope) {
+    return scope >= 0 && scope < scopeCount ? scopeList[scope]->nextOffset : 0;
 }
 
 int getVarOffset(char* name) {
-    SymNode* n = lookup(name);
-    return n ? n->offset : -1;
+    int id = lookup(name);
+    return id >= 0 ? symtab.vars[id].offset : -1;
 }
 
 int isVarDeclared(char* name) {
-    return lookup(name) != NULL;
+    return lookup(name) >= 0;
 }
 
 void printSymTab() {
     printf("\n=== SYMBOL TABLE (by scope) ===\n");
-    printf("Total Count: %d, Next Offset: %d\n", symtab.count, symtab.nextOffset);
+    printf("Total Count: %d\n", symtab.count);
     for (int i = 0; i < scopeCount; i++) {
         ScopeFrame* s = scopeList[i];
-        printf("Scope: %s\n", s->name);
+        printf("Scope: %s (%d bytes)\n", s->name, s->nextOffset);
         int empty = 1;
-        for (int b = 0; b < HASH_SIZE; b++) {
-            for (SymNode* n = s->buckets[b]; n; n = n->next) {
-                empty = 0;
-                if (n->isArray) printf("  %s[%d] -> offset %d\n", n->name, n->arraySize, n->offset);
-                else printf("  %s -> offset %d\n", n->name, n->offset);
-            }
+        for (SymNode* n = s->firstDecl; n; n = n->nextDecl) {
+            Symbol* sym = &symtab.vars[n->id];
+            empty = 0;
+            if (sym->isArray) printf("  %s[%d] -> offset %d\n", sym->name, sym->arraySize, sym->offset);
+            else printf("  %s -> offset %d\n", sym->name, sym->offset);
         }
         if (empty) printf("  (empty)\n");
     }
     printf("==============================\n\n");
 }
+
+void printSymTabStats() {
+    static const char* binNames[PROBE_BINS] = { "0", "1", "2", "3", "4-7", "8+" };
+    long chainHist[PROBE_BINS] = { 0 };
+    long buckets = 0;
+    int longest = 0;
+    for (int i = 0; i < scopeCount; i++) {
+        ScopeFrame* s = scopeList[i];
+        buckets += s->bucketCount;
+        for (int b = 0; b < s->bucketCount; b++) {
+            int len = 0;
+            for (SymNode* n = s->buckets[b]; n; n = n->next) len++;
+            chainHist[probeBin(len)]++;
+            if (len > longest) longest = len;
+        }
+    }
+
+    printf("\n=== SYMBOL TABLE STATISTICS ===\n");
+    printf("Scopes: %d, Symbols: %d, Buckets: %ld (load %.2f), Rehashes: %ld\n",
+           scopeCount, symtab.count, buckets,
+           buckets ? (double)symtab.count / buckets : 0.0, stats.rehashes);
+    printf("Inserts: %ld (%ld duplicates rejected)\n", stats.inserts, stats.duplicates);
+    printf("Lookups: %ld (%ld walked to a parent scope, %ld not found)\n",
+           stats.lookups, stats.parentWalks, stats.misses);
+    printf("Scope probes: %ld, chain nodes visited: %ld (%.2f per probe), strcmp calls: %ld\n",
+           stats.scopeProbes, stats.chainSteps,
+           stats.scopeProbes ? (double)stats.chainSteps / stats.scopeProbes : 0.0,
+           stats.strcmps);
+    printf("Nodes visited per probe:");
+    for (int i = 0; i < PROBE_BINS; i++) printf("  %s: %ld", binNames[i], stats.probeHist[i]);
+    printf("\nBucket chain lengths:   ");
+    for (int i = 0; i < PROBE_BINS; i++) printf("  %s: %ld", binNames[i], chainHist[i]);
+    printf("  (longest %d)\n", longest);
+    printf("===============================\n\n");
+}
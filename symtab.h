@@ -7,8 +7,6 @@
  * Scope management is supported via a simple scope stack (global + per function).
  */
 
-#define MAX_VARS 1000000  /* Maximum number of variables supported */
-
 /* SYMBOL ENTRY - Information about each variable */
 // In symtab.h
 typedef struct {
@@ -16,13 +14,18 @@ typedef struct {
     int offset;         /* Stack offset */
     int isArray;        /* Flag: 1 if it's an array, 0 otherwise */
     int arraySize;      /* Number of elements if it's an array */
+    int type;           /* VarType of the variable (TYPE_INT / TYPE_FLOAT) */
+    int scope;          /* Declaring scope: 0 = global, otherwise a function */
 } Symbol;
 
-/* SYMBOL TABLE STRUCTURE */
+/* SYMBOL TABLE STRUCTURE
+ * vars is a growable vector holding every symbol in declaration order;
+ * a symbol's index in it never changes, so scopes refer to symbols by index.
+ */
 typedef struct {
-    Symbol vars[MAX_VARS];  /* Array of all variables */
+    Symbol* vars;           /* All variables, in declaration order */
     int count;              /* Number of variables declared */
-    int nextOffset;         /* Next available stack offset */
+    int capacity;           /* Allocated slots in vars */
 } SymbolTable;
 
 /* SYMBOL TABLE OPERATIONS */
@@ -30,8 +33,16 @@ void initSymTab();               /* Initialize empty symbol table */
 void pushScope(const char* name);/* Enter a new lexical scope (e.g., function) */
 void popScope();                 /* Exit current scope */
 int addVar(char* name);          /* Add new variable, returns offset or -1 if duplicate */
+int addArray(char* name, int size); /* Add new array, returns offset or -1 if duplicate */
+int addSymbol(char* name, int type, int isArray, int arraySize); /* Returns symbol id or -1 if duplicate */
+int lookupSymbol(char* name);    /* Resolve name through the scope chain, symbol id or -1 */
+Symbol* getSymbol(int id);       /* Symbol metadata by id (O(1)) */
+int getSymbolCount();            /* Number of symbols (ids are 0..count-1) */
+int getCurrentScope();           /* Index of the innermost scope (0 = global) */
+int getScopeSize(int scope);     /* Bytes of stack allocated in a scope */
 int getVarOffset(char* name);    /* Get stack offset for variable, -1 if not found */
 int isVarDeclared(char* name);   /* Check if variable exists (1=yes, 0=no) */
 void printSymTab();              /* Debug: print current symbol table contents */
+void printSymTabStats();         /* Hash table counters and chain-length histograms */
 
-#endif
\ No newline at end of file
+#endif
@@ -1,99 +1,270 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdbool.h>
+#include <limits.h>
 #include "tac.h"
+#include "symtab.h"
+#include "bitset.h"
+#include "pipeline.h"
+
+TACProgram tacProgram;
+OptStats optStats;
+static int currentFunc = 0;     /* Function receiving generated code */
+
+/* LABEL TABLE
+ * Function names are interned once; TAC refers to them by id.
+ */
+static char** labels = NULL;        /* id -> name */
+static int labelCount = 0;
+static int labelCapacity = 0;
+static int* labelSlots = NULL;      /* open-addressing hash: name -> id + 1 */
+static int labelSlotCount = 0;
+
+static unsigned int hashName(const char* s) {
+    unsigned int h = 5381;
+    int c;
+    while ((c = *s++)) h = ((h << 5) + h) + (unsigned char)c;
+    return h;
+}
+
+static void* xrealloc(void* p, size_t size) {
+    p = realloc(p, size);
+    if (!p) {
+        fprintf(stderr, "Out of memory in TAC\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void rehashLabels(int slotCount) {
+    free(labelSlots);
+    labelSlots = calloc(slotCount, sizeof(int));
+    if (!labelSlots) {
+        fprintf(stderr, "Out of memory in TAC\n");
+        exit(1);
+    }
+    labelSlotCount = slotCount;
+    for (int id = 0; id < labelCount; id++) {
+        unsigned int h = hashName(labels[id]) & (slotCount - 1);
+        while (labelSlots[h]) h = (h + 1) & (slotCount - 1);
+        labelSlots[h] = id + 1;
+    }
+}
+
+int internLabel(const char* name) {
+    if (labelSlotCount == 0) rehashLabels(64);
+    unsigned int h = hashName(name) & (labelSlotCount - 1);
+    while (labelSlots[h]) {
+        int id = labelSlots[h] - 1;
+        if (strcmp(labels[id], name) == 0) return id;
+        h = (h + 1) & (labelSlotCount - 1);
+    }
+    if (labelCount >= labelCapacity) {
+        labelCapacity = labelCapacity ? labelCapacity * 2 : 32;
+        labels = xrealloc(labels, sizeof(char*) * labelCapacity);
+    }
+    labels[labelCount] = strdup(name);
+    labelSlots[h] = labelCount + 1;
+    labelCount++;
+    if (labelCount * 2 > labelSlotCount) rehashLabels(labelSlotCount * 2);
+    return labelCount - 1;
+}
+
+const char* labelName(int label) {
+    return labels[label];
+}
+
+/* OPERAND HELPERS */
+TACOperand noOperand() {
+    TACOperand op;
+    op.kind = OPR_NONE;
+    op.ver = 0;
+    op.u.ival = 0;
+    return op;
+}
+
+TACOperand tempOperand(int temp) {
+    TACOperand op;
+    op.kind = OPR_TEMP;
+    op.ver = 0;
+    op.u.temp = temp;
+    return op;
+}
 
-TACList tacList;
-TACList optimizedList;
+TACOperand symOperand(int sym) {
+    TACOperand op;
+    op.kind = OPR_SYM;
+    op.ver = 0;
+    op.u.sym = sym;
+    return op;
+}
+
+TACOperand intOperand(int value) {
+    TACOperand op;
+    op.kind = OPR_INT;
+    op.ver = 0;
+    op.u.ival = value;
+    return op;
+}
+
+TACOperand floatOperand(double value) {
+    TACOperand op;
+    op.kind = OPR_FLOAT;
+    op.ver = 0;
+    op.u.fval = value;
+    return op;
+}
+
+TACOperand labelOperand(int label) {
+    TACOperand op;
+    op.kind = OPR_LABEL;
+    op.ver = 0;
+    op.u.label = label;
+    return op;
+}
+
+int sameOperand(TACOperand a, TACOperand b) {
+    if (a.kind != b.kind) return 0;
+    switch (a.kind) {
+        case OPR_NONE:  return 1;
+        case OPR_TEMP:  return a.u.temp == b.u.temp;
+        case OPR_SYM:   return a.u.sym == b.u.sym && a.ver == b.ver;
+        case OPR_INT:   return a.u.ival == b.u.ival;
+        case OPR_FLOAT: return a.u.fval == b.u.fval;
+        case OPR_LABEL: return a.u.label == b.u.label;
+    }
+    return 0;
+}
+
+const char* operandToString(TACOperand op, char* buf, int size) {
+    switch (op.kind) {
+        case OPR_NONE:  snprintf(buf, size, "(null)"); break;
+        case OPR_TEMP:  snprintf(buf, size, "t%d", op.u.temp); break;
+        case OPR_SYM:
+            if (op.ver) snprintf(buf, size, "%s.%d", getSymbol(op.u.sym)->name, op.ver);
+            else snprintf(buf, size, "%s", getSymbol(op.u.sym)->name);
+            break;
+        case OPR_INT:   snprintf(buf, size, "%d", op.u.ival); break;
+        case OPR_FLOAT: snprintf(buf, size, "%g", op.u.fval); break;
+        case OPR_LABEL: snprintf(buf, size, "%s", labelName(op.u.label)); break;
+    }
+    return buf;
+}
+
+int addFunction(int name, int scope) {
+    if (tacProgram.funcCount >= tacProgram.funcCapacity) {
+        tacProgram.funcCapacity = tacProgram.funcCapacity ? tacProgram.funcCapacity * 2 : 16;
+        tacProgram.funcs = xrealloc(tacProgram.funcs, sizeof(TACFunction) * tacProgram.funcCapacity);
+    }
+    TACFunction* fn = &tacProgram.funcs[tacProgram.funcCount];
+    fn->name = name;
+    fn->scope = scope;
+    fn->params = NULL;
+    fn->paramCount = 0;
+    fn->code = NULL;
+    fn->count = 0;
+    fn->capacity = 0;
+    return tacProgram.funcCount++;
+}
 
 void initTAC() {
-    tacList.head = NULL;
-    tacList.tail = NULL;
-    tacList.tempCount = 0;
-    optimizedList.head = NULL;
-    optimizedList.tail = NULL;
-}
-
-char* newTemp() {
-    char* temp = malloc(10);
-    sprintf(temp, "t%d", tacList.tempCount++);
-    return temp;
-}
-
-TACInstr* createTAC(TACOp op, char* arg1, char* arg2, char* result) {
-    TACInstr* instr = malloc(sizeof(TACInstr));
-    instr->op = op;
-    instr->arg1 = arg1 ? strdup(arg1) : NULL;
-    instr->arg2 = arg2 ? strdup(arg2) : NULL;
-    instr->result = result ? strdup(result) : NULL;
-    instr->paramCount = 0;
-    instr->next = NULL;
+    for (int i = 0; i < tacProgram.funcCount; i++) {
+        free(tacProgram.funcs[i].code);
+        free(tacProgram.funcs[i].params);
+    }
+    tacProgram.funcCount = 0;
+    tacProgram.tempCount = 0;
+    tacProgram.phiArgCount = 0;
+    currentFunc = addFunction(internLabel("main"), 0);
+}
+
+TACOperand newTemp() {
+    return tempOperand(tacProgram.tempCount++);
+}
+
+TACInstr createTAC(TACOp op, TACOperand arg1, TACOperand arg2, TACOperand result) {
+    TACInstr instr;
+    instr.op = op;
+    instr.arg1 = arg1;
+    instr.arg2 = arg2;
+    instr.result = result;
+    instr.paramCount = 0;
     return instr;
 }
 
-void appendTAC(TACInstr* instr) {
-    if (!tacList.head) {
-        tacList.head = tacList.tail = instr;
-    } else {
-        tacList.tail->next = instr;
-        tacList.tail = instr;
+int appendTAC(const TACInstr* instr) {
+    TACFunction* fn = &tacProgram.funcs[currentFunc];
+    if (fn->count >= fn->capacity) {
+        fn->capacity = fn->capacity ? fn->capacity * 2 : 32;
+        fn->code = xrealloc(fn->code, sizeof(TACInstr) * fn->capacity);
+    }
+    fn->code[fn->count] = *instr;
+    return fn->count++;
+}
+
+/* createTAC + appendTAC, built here so the instruction does not take
+   space in the frames of the recursive generators below */
+static int emitTAC(TACOp op, TACOperand arg1, TACOperand arg2, TACOperand result) {
+    TACInstr instr = createTAC(op, arg1, arg2, result);
+    return appendTAC(&instr);
+}
+
+int newPhiArgs(int count) {
+    if (tacProgram.phiArgCount + count > tacProgram.phiArgCapacity) {
+        while (tacProgram.phiArgCount + count > tacProgram.phiArgCapacity)
+            tacProgram.phiArgCapacity = tacProgram.phiArgCapacity ? tacProgram.phiArgCapacity * 2 : 64;
+        tacProgram.phiArgs = xrealloc(tacProgram.phiArgs, sizeof(TACOperand) * tacProgram.phiArgCapacity);
     }
+    for (int i = 0; i < count; i++) tacProgram.phiArgs[tacProgram.phiArgCount + i] = noOperand();
+    tacProgram.phiArgCount += count;
+    return tacProgram.phiArgCount - count;
 }
 
-void appendOptimizedTAC(TACInstr* instr) {
-    if (!optimizedList.head) {
-        optimizedList.head = optimizedList.tail = instr;
-    } else {
-        optimizedList.tail->next = instr;
-        optimizedList.tail = instr;
+void compactTAC(TACFunction* fn) {
+    int out = 0;
+    for (int i = 0; i < fn->count; i++) {
+        if (fn->code[i].op != TAC_NOP) fn->code[out++] = fn->code[i];
     }
+    fn->count = out;
 }
 
-char* generateTACExpr(ASTNode* node) {
-    if (!node) return NULL;
-    
+TACOperand generateTACExpr(ASTNode* node) {
+    if (!node) return noOperand();
+
     switch(node->type) {
-        case NODE_NUM: {
-            char* temp = malloc(20);
-            sprintf(temp, "%d", node->data.num);
-            return temp;
-        }
-        case NODE_FNUM: {
-            char* temp = malloc(32);
-            sprintf(temp, "%g", node->data.fnum);
-            return temp;
-        }
-        
+        case NODE_NUM:
+            return intOperand(node->data.num);
+        case NODE_FNUM:
+            return floatOperand(node->data.fnum);
+
         case NODE_VAR:
-            return strdup(node->data.name);
-        
+            return symOperand(node->sym);
+
         case NODE_BINOP: {
-            char* left = generateTACExpr(node->data.binop.left);
-            char* right = generateTACExpr(node->data.binop.right);
-            char* temp = newTemp();
-            
+            TACOperand left = generateTACExpr(node->data.binop.left);
+            TACOperand right = generateTACExpr(node->data.binop.right);
+            TACOperand temp = newTemp();
+
             if (node->data.binop.op == '+') {
-                appendTAC(createTAC(TAC_ADD, left, right, temp));
+                emitTAC(TAC_ADD, left, right, temp);
             }
             else if (node->data.binop.op == '-') {
-                appendTAC(createTAC(TAC_SUB, left, right, temp));
+                emitTAC(TAC_SUB, left, right, temp);
             }
             else if (node->data.binop.op == '*') {
-                appendTAC(createTAC(TAC_MUL, left, right, temp));
+                emitTAC(TAC_MUL, left, right, temp);
             }
             else if (node->data.binop.op == '/') {
-                appendTAC(createTAC(TAC_DIV, left, right, temp));
+                emitTAC(TAC_DIV, left, right, temp);
             }
-            
+
             return temp;
         }
-        
+
         case NODE_ARRAY_ACCESS: {
-            char* index = generateTACExpr(node->data.array_access.index);
-            char* temp = newTemp();
-            appendTAC(createTAC(TAC_LOAD, node->data.array_access.name, index, temp));
+            TACOperand index = generateTACExpr(node->data.array_access.index);
+            TACOperand temp = newTemp();
+            emitTAC(TAC_LOAD, symOperand(node->sym), index, temp);
             return temp;
         }
         case NODE_FUNC_CALL: {
@@ -101,98 +272,209 @@ char* generateTACExpr(ASTNode* node) {
             int paramCount = 0;
             ASTNode* a = node->data.func_call.args;
             while (a) {
-                char* argVal = generateTACExpr(a->data.arg_list.expr);
-                appendTAC(createTAC(TAC_PARAM, argVal, NULL, NULL));
+                TACOperand argVal = generateTACExpr(a->data.arg_list.expr);
+                emitTAC(TAC_PARAM, argVal, noOperand(), noOperand());
                 paramCount++;
                 a = a->data.arg_list.next;
             }
             /* Emit CALL and return temp holding result */
-            char* temp = newTemp();
-            TACInstr* callInstr = createTAC(TAC_CALL, node->data.func_call.name, NULL, temp);
-            callInstr->paramCount = paramCount;
-            appendTAC(callInstr);
+            TACOperand temp = newTemp();
+            TACInstr callInstr = createTAC(TAC_CALL, labelOperand(internLabel(node->data.func_call.name)),
+                                           noOperand(), temp);
+            callInstr.paramCount = paramCount;
+            appendTAC(&callInstr);
             return temp;
         }
-        
+
         default:
-            return NULL;
+            return noOperand();
     }
 }
 
-void generateTAC(ASTNode* node) {
-    if (!node) return;
-    
+/* One statement or declaration; statement lists are walked by generateTAC */
+static void generateStmtTAC(ASTNode* node) {
     switch(node->type) {
         case NODE_DECL:
-            appendTAC(createTAC(TAC_DECL, NULL, NULL, node->data.name));
+            emitTAC(TAC_DECL, noOperand(), noOperand(), symOperand(node->sym));
             break;
 
-        case NODE_ARRAY_DECL: {
-            char sizeStr[20];
-            sprintf(sizeStr, "%d", node->data.array_decl.size);
-            appendTAC(createTAC(TAC_DECL_ARRAY, strdup(sizeStr), NULL, node->data.array_decl.name));
+        case NODE_ARRAY_DECL:
+            emitTAC(TAC_DECL_ARRAY, intOperand(node->data.array_decl.size), noOperand(),
+                    symOperand(node->sym));
             break;
-        }
-            
+
         case NODE_ASSIGN: {
-            char* expr = generateTACExpr(node->data.assign.value);
-            appendTAC(createTAC(TAC_ASSIGN, expr, NULL, node->data.assign.var));
+            TACOperand expr = generateTACExpr(node->data.assign.value);
+            emitTAC(TAC_ASSIGN, expr, noOperand(), symOperand(node->sym));
             break;
         }
 
         case NODE_ARRAY_ASSIGN: {
-            char* index = generateTACExpr(node->data.array_assign.index);
-            char* value = generateTACExpr(node->data.array_assign.value);
-            appendTAC(createTAC(TAC_STORE, index, value, node->data.array_assign.name));
+            TACOperand index = generateTACExpr(node->data.array_assign.index);
+            TACOperand value = generateTACExpr(node->data.array_assign.value);
+            emitTAC(TAC_STORE, index, value, symOperand(node->sym));
             break;
         }
-        
+
         case NODE_PRINT: {
-            char* expr = generateTACExpr(node->data.expr);
-            appendTAC(createTAC(TAC_PRINT, expr, NULL, NULL));
+            TACOperand expr = generateTACExpr(node->data.expr);
+            emitTAC(TAC_PRINT, expr, noOperand(), noOperand());
             break;
         }
-        
-        case NODE_STMT_LIST:
-            generateTAC(node->data.stmtlist.stmt);
-            generateTAC(node->data.stmtlist.next);
-            break;
+
         case NODE_FUNC_DECL: {
+            /* Each function gets its own instruction array */
+            TACOperand name = labelOperand(internLabel(node->data.func_decl.name));
+            int outer = currentFunc;
+            currentFunc = addFunction(name.u.label, node->data.func_decl.scope);
+            TACFunction* fn = &tacProgram.funcs[currentFunc];
+            for (ASTNode* p = node->data.func_decl.params; p; p = p->data.param_list.next) {
+                fn->params = xrealloc(fn->params, sizeof(int) * (fn->paramCount + 1));
+                fn->params[fn->paramCount++] = p->sym;
+            }
             /* Mark function begin and label */
-            appendTAC(createTAC(TAC_FUNC_BEGIN, NULL, NULL, node->data.func_decl.name));
-            appendTAC(createTAC(TAC_LABEL, NULL, NULL, node->data.func_decl.name));
+            emitTAC(TAC_FUNC_BEGIN, noOperand(), noOperand(), name);
+            emitTAC(TAC_LABEL, noOperand(), noOperand(), name);
             /* Generate TAC for the body */
             generateTAC(node->data.func_decl.body);
-            appendTAC(createTAC(TAC_FUNC_END, NULL, NULL, node->data.func_decl.name));
+            emitTAC(TAC_FUNC_END, noOperand(), noOperand(), name);
+            currentFunc = outer;
             break;
         }
-        case NODE_FUNC_CALL: {
-            /* Generate TAC for call with no args (minimal) */
-            int paramCount = 0;
-            ASTNode* a = node->data.func_call.args;
-            while (a) {
-                char* argVal = generateTACExpr(a->data.arg_list.expr);
-                appendTAC(createTAC(TAC_PARAM, argVal, NULL, NULL));
-                paramCount++;
-                a = a->data.arg_list.next;
-            }
-            char* temp = newTemp();
-            TACInstr* callInstr = createTAC(TAC_CALL, node->data.func_call.name, NULL, temp);
-            callInstr->paramCount = paramCount;
-            appendTAC(callInstr);
-            /* Return value represented by temp */
+        case NODE_FUNC_CALL:
+            /* Call used as a statement: result temp is simply unused */
+            generateTACExpr(node);
             break;
-        }
         case NODE_RETURN: {
             if (node->data.return_expr) {
-                char* ret = generateTACExpr(node->data.return_expr);
-                appendTAC(createTAC(TAC_RETURN, ret, NULL, NULL));
+                TACOperand ret = generateTACExpr(node->data.return_expr);
+                emitTAC(TAC_RETURN, ret, noOperand(), noOperand());
             } else {
-                appendTAC(createTAC(TAC_RETURN, NULL, NULL, NULL));
+                emitTAC(TAC_RETURN, noOperand(), noOperand(), noOperand());
             }
             break;
         }
-            
+
+        default:
+            break;
+    }
+}
+
+/* Statement lists nest on both sides (the parser builds them left-deep),
+   so they are walked with an explicit stack: recursing would need stack
+   proportional to the program's length */
+void generateTAC(ASTNode* node) {
+    if (!node) return;
+    int capacity = 64, count = 0;
+    ASTNode** stack = xrealloc(NULL, sizeof(ASTNode*) * capacity);
+    stack[count++] = node;
+    while (count > 0) {
+        node = stack[--count];
+        if (!node) continue;
+        if (node->type != NODE_STMT_LIST) {
+            generateStmtTAC(node);
+            continue;
+        }
+        if (count + 2 > capacity) {
+            capacity *= 2;
+            stack = xrealloc(stack, sizeof(ASTNode*) * capacity);
+        }
+        stack[count++] = node->data.stmtlist.next;
+        stack[count++] = node->data.stmtlist.stmt;
+    }
+    free(stack);
+}
+
+/* Print every live instruction of every function, numbering them */
+static void printProgram(void (*printInstr)(TACInstr* curr)) {
+    int lineNum = 1;
+    for (int f = 0; f < tacProgram.funcCount; f++) {
+        TACFunction* fn = &tacProgram.funcs[f];
+        for (int i = 0; i < fn->count; i++) {
+            if (fn->code[i].op == TAC_NOP) continue;
+            printf("%2d: ", lineNum++);
+            printInstr(&fn->code[i]);
+        }
+    }
+}
+
+static void printUnoptimizedInstr(TACInstr* curr) {
+    char a1[64], a2[64], res[64];
+    operandToString(curr->arg1, a1, sizeof(a1));
+    operandToString(curr->arg2, a2, sizeof(a2));
+    operandToString(curr->result, res, sizeof(res));
+    switch(curr->op) {
+        case TAC_DECL:
+            printf("DECL %s", res);
+            printf("           // Declare variable '%s'\n", res);
+            break;
+        case TAC_ADD:
+            printf("%s = %s + %s", res, a1, a2);
+            printf("     // Add: store result in %s\n", res);
+            break;
+        case TAC_MUL:
+            printf("%s = %s * %s", res, a1, a2);
+            printf("     // Multiply: store result in %s\n", res);
+            break;
+        case TAC_DIV:
+            printf("%s = %s / %s", res, a1, a2);
+            printf("     // Divide: store result in %s\n", res);
+            break;
+        case TAC_SUB:
+            printf("%s = %s - %s", res, a1, a2);
+            printf("     // Subtract: store result in %s\n", res);
+            break;
+        case TAC_ASSIGN:
+            printf("%s = %s", res, a1);
+            printf("           // Assign value to %s\n", res);
+            break;
+        case TAC_PRINT:
+            printf("PRINT %s", a1);
+            printf("           // Output value of %s\n", a1);
+            break;
+        case TAC_DECL_ARRAY:
+            printf("DECL_ARRAY %s[%s]", res, a1);
+            printf("   // Declare array '%s' of size %s\n", res, a1);
+            break;
+        case TAC_LABEL:
+            printf("LABEL %s\n", res);
+            break;
+        case TAC_PARAM:
+            printf("PARAM %s\n", a1);
+            break;
+        case TAC_CALL:
+            printf("%s = CALL %s, %d\n", res, a1, curr->paramCount);
+            break;
+        case TAC_RETURN:
+            if (curr->arg1.kind != OPR_NONE) printf("RETURN %s\n", a1);
+            else printf("RETURN\n");
+            break;
+        case TAC_FUNC_BEGIN:
+            printf("FUNC_BEGIN %s\n", res);
+            break;
+        case TAC_FUNC_END:
+            printf("FUNC_END %s\n", res);
+            break;
+        case TAC_STORE:
+            printf("%s[%s] = %s", res, a1, a2);
+            printf("       // Store value in array '%s'\n", res);
+            break;
+        case TAC_LOAD:
+            printf("%s = %s[%s]", res, a1, a2);
+            printf("       // Load value from array '%s'\n", a1);
+            break;
+        case TAC_SHL:
+            printf("%s = %s << %s", res, a1, a2);
+            printf("     // Shift left: store result in %s\n", res);
+            break;
+        case TAC_SRA:
+            printf("%s = %s >> %s", res, a1, a2);
+            printf("     // Arithmetic shift right: store result in %s\n", res);
+            break;
+        case TAC_SRL:
+            printf("%s = %s >>> %s", res, a1, a2);
+            printf("     // Logical shift right: store result in %s\n", res);
+            break;
         default:
             break;
     }
@@ -201,452 +483,521 @@ void generateTAC(ASTNode* node) {
 void printTAC() {
     printf("Unoptimized TAC Instructions:\n");
     printf("─────────────────────────────\n");
-    TACInstr* curr = tacList.head;
-    int lineNum = 1;
-    while (curr) {
-        printf("%2d: ", lineNum++);
-        switch(curr->op) {
-            case TAC_DECL:
-                printf("DECL %s", curr->result);
-                printf("           // Declare variable '%s'\n", curr->result);
-                break;
-            case TAC_ADD:
-                printf("%s = %s + %s", curr->result, curr->arg1, curr->arg2);
-                printf("     // Add: store result in %s\n", curr->result);
-                break;
-            case TAC_MUL:
-                printf("%s = %s * %s", curr->result, curr->arg1, curr->arg2);
-                printf("     // Multiply: store result in %s\n", curr->result);
-                break;
-            case TAC_DIV:
-                printf("%s = %s / %s", curr->result, curr->arg1, curr->arg2);
-                printf("     // Divide: store result in %s\n", curr->result);
-                break;
-            case TAC_SUB:
-                printf("%s = %s - %s", curr->result, curr->arg1, curr->arg2);
-                printf("     // Subtract: store result in %s\n", curr->result);
-                break;
-            case TAC_ASSIGN:
-                printf("%s = %s", curr->result, curr->arg1);
-                printf("           // Assign value to %s\n", curr->result);
-                break;
-            case TAC_PRINT:
-                printf("PRINT %s", curr->arg1);
-                printf("           // Output value of %s\n", curr->arg1);
-                break;
-            case TAC_DECL_ARRAY:
-                printf("DECL_ARRAY %s[%s]", curr->result, curr->arg1);
-                printf("   // Declare array '%s' of size %s\n", curr->result, curr->arg1);
-                break;
-            case TAC_LABEL:
-                printf("LABEL %s\n", curr->result);
-                break;
-            case TAC_PARAM:
-                printf("PARAM %s\n", curr->arg1);
-                break;
-            case TAC_CALL:
-                printf("%s = CALL %s, %d\n", curr->result, curr->arg1, curr->paramCount);
-                break;
-            case TAC_RETURN:
-                if (curr->arg1) printf("RETURN %s\n", curr->arg1);
-                else printf("RETURN\n");
-                break;
-            case TAC_FUNC_BEGIN:
-                printf("FUNC_BEGIN %s\n", curr->result);
-                break;
-            case TAC_FUNC_END:
-                printf("FUNC_END %s\n", curr->result);
-                break;
-            case TAC_STORE:
-                printf("%s[%s] = %s", curr->result, curr->arg1, curr->arg2);
-                printf("       // Store value in array '%s'\n", curr->result);
+    printProgram(printUnoptimizedInstr);
+}
+
+/* VALUE NUMBERING
+ * Variables and temporaries share one dense id space: symbol ids first,
+ * then temporaries. Passes index their per-value tables with these ids.
+ */
+int valueCount() {
+    return getSymbolCount() + tacProgram.tempCount;
+}
+
+int valueId(TACOperand op) {
+    if (op.kind == OPR_SYM) return op.u.sym;
+    if (op.kind == OPR_TEMP) return getSymbolCount() + op.u.temp;
+    return -1;
+}
+
+int definesResult(TACOp op) {
+    switch (op) {
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV:
+        case TAC_ASSIGN: case TAC_LOAD: case TAC_CALL: case TAC_PHI:
+        case TAC_SHL: case TAC_SRA: case TAC_SRL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* FLOAT OPERANDS
+ * TAC is untyped, so float-ness is inferred forward through a function:
+ * a temp holds a float when anything it is computed from does. Temps
+ * created after inference are ints.
+ */
+static char* floatTemp = NULL;     /* Temp -> holds a float value */
+static int floatTempSize = 0;
+
+int isFloatOperand(TACOperand op) {
+    switch (op.kind) {
+        case OPR_FLOAT: return 1;
+        case OPR_SYM: return getSymbol(op.u.sym)->type == TYPE_FLOAT;
+        case OPR_TEMP: return op.u.temp < floatTempSize && floatTemp[op.u.temp];
+        default: return 0;
+    }
+}
+
+void inferFloatTemps(TACFunction* fn) {
+    if (tacProgram.tempCount > floatTempSize) {
+        floatTemp = realloc(floatTemp, tacProgram.tempCount);
+        if (!floatTemp) {
+            fprintf(stderr, "Out of memory in inferFloatTemps\n");
+            exit(1);
+        }
+        floatTempSize = tacProgram.tempCount;
+    }
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* in = &fn->code[i];
+        if (in->result.kind != OPR_TEMP || !definesResult(in->op)) continue;
+        int isFloat = 0;
+        switch (in->op) {
+            case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_ASSIGN:
+                isFloat = isFloatOperand(in->arg1) || isFloatOperand(in->arg2);
                 break;
             case TAC_LOAD:
-                printf("%s = %s[%s]", curr->result, curr->arg1, curr->arg2);
-                printf("       // Load value from array '%s'\n", curr->arg1);
+                isFloat = isFloatOperand(in->arg1);
+                break;
+            case TAC_PHI:
+                for (int a = 0; a < in->paramCount; a++) {
+                    isFloat |= isFloatOperand(tacProgram.phiArgs[in->arg1.u.ival + a]);
+                }
                 break;
             default:
                 break;
         }
-        curr = curr->next;
+        floatTemp[in->result.u.temp] = isFloat;
     }
 }
 
-// Simple optimization: constant folding and copy propagation
-void optimizeTAC() {
-    TACInstr* curr = tacList.head;
-    
-    // Copy propagation table
-    typedef struct {
-        char* var;
-        char* value;
-    } VarValue;
-
-    /* Use a dynamically-sized array to avoid stack overflow when
-       the input produces many temporaries/assignments. */
-    int valueCount = 0;
-    int valuesCapacity = 256;
-    VarValue* values = malloc(sizeof(VarValue) * valuesCapacity);
-    if (!values) {
-        fprintf(stderr, "Out of memory in optimizeTAC\n");
-        exit(1);
-    }
-    
-    while (curr) {
-        TACInstr* newInstr = NULL;
-        
-    switch(curr->op) {
-            case TAC_DECL:
-                newInstr = createTAC(TAC_DECL, NULL, NULL, curr->result);
-                break;
-                
-            case TAC_ADD: {
-                char* left = curr->arg1;
-                char* right = curr->arg2;
-                
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, left) == 0) {
-                        left = values[i].value;
-                        break;
-                    }
-                }
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, right) == 0) {
-                        right = values[i].value;
-                        break;
-                    }
-                }
-                
-                if (isdigit(left[0]) && isdigit(right[0])) {
-                    int result = atoi(left) + atoi(right);
-                    char* resultStr = malloc(20);
-                    sprintf(resultStr, "%d", result);
-                    
-                    if (valueCount >= valuesCapacity) {
-                        valuesCapacity *= 2;
-                        values = realloc(values, sizeof(VarValue) * valuesCapacity);
-                        if (!values) {
-                            fprintf(stderr, "Out of memory in optimizeTAC (realloc)\n");
-                            exit(1);
-                        }
-                    }
-                    values[valueCount].var = strdup(curr->result);
-                    values[valueCount].value = resultStr;
-                    valueCount++;
-                    
-                    newInstr = createTAC(TAC_ASSIGN, resultStr, NULL, curr->result);
-                } else {
-                    newInstr = createTAC(TAC_ADD, left, right, curr->result);
-                }
-                break;
-            }
+static int isGlobalValue(int id) {
+    return id >= 0 && id < getSymbolCount() && getSymbol(id)->scope == 0;
+}
 
-            case TAC_SUB: {
-                char* left = curr->arg1;
-                char* right = curr->arg2;
-                
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, left) == 0) {
-                        left = values[i].value;
-                        break;
-                    }
-                }
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, right) == 0) {
-                        right = values[i].value;
-                        break;
-                    }
-                }
-                
-                if (isdigit(left[0]) && isdigit(right[0])) {
-                    int result = atoi(left) - atoi(right);
-                    char* resultStr = malloc(20);
-                    sprintf(resultStr, "%d", result);
-                    
-                    if (valueCount >= valuesCapacity) {
-                        valuesCapacity *= 2;
-                        values = realloc(values, sizeof(VarValue) * valuesCapacity);
-                        if (!values) {
-                            fprintf(stderr, "Out of memory in optimizeTAC (realloc)\n");
-                            exit(1);
-                        }
-                    }
-                    values[valueCount].var = strdup(curr->result);
-                    values[valueCount].value = resultStr;
-                    valueCount++;
-                    
-                    newInstr = createTAC(TAC_ASSIGN, resultStr, NULL, curr->result);
-                } else {
-                    newInstr = createTAC(TAC_SUB, left, right, curr->result);
-                }
-                break;
-            }
-            case TAC_MUL: {
-                char* left = curr->arg1;
-                char* right = curr->arg2;
-
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, left) == 0) {
-                        left = values[i].value;
-                        break;
-                    }
-                }
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, right) == 0) {
-                        right = values[i].value;
-                        break;
-                    }
-                }
+/* Copy propagation table
+ * Indexed by value id. An entry holds the value last copied into a
+ * variable and is only trusted while it is still current:
+ *  - gen must match the function being optimized (no clearing between functions)
+ *  - the source variable must not have been redefined since (version check)
+ *  - no call may have happened since if either side is a global (epoch check)
+ */
+typedef struct {
+    TACOperand value;   /* Known value */
+    int gen;            /* Function generation that recorded it */
+    int src;            /* Value id of the source variable, or -1 for constants */
+    int srcVersion;     /* version[src] when recorded */
+    int epoch;          /* Call epoch when recorded */
+} ValueEntry;
+
+typedef struct {
+    ValueEntry* entries;   /* One per value id */
+    int* version;          /* Bumped on every definition of a value */
+    int gen;
+    int epoch;
+} ValueTable;
+
+/* Current known value of an operand, or the operand itself */
+static TACOperand propagate(ValueTable* values, TACOperand op) {
+    int id = valueId(op);
+    if (id < 0) return op;
+    ValueEntry* e = &values->entries[id];
+    if (e->gen != values->gen) return op;
+    if (e->src >= 0 && values->version[e->src] != e->srcVersion) return op;
+    if (e->epoch != values->epoch && (isGlobalValue(id) || isGlobalValue(e->src))) return op;
+    return e->value;
+}
 
-                if (isdigit(left[0]) && isdigit(right[0])) {
-                    int result = atoi(left) * atoi(right);
-                    char* resultStr = malloc(20);
-                    sprintf(resultStr, "%d", result);
-
-                    if (valueCount >= valuesCapacity) {
-                        valuesCapacity *= 2;
-                        values = realloc(values, sizeof(VarValue) * valuesCapacity);
-                        if (!values) {
-                            fprintf(stderr, "Out of memory in optimizeTAC (realloc)\n");
-                            exit(1);
-                        }
-                    }
-                    values[valueCount].var = strdup(curr->result);
-                    values[valueCount].value = resultStr;
-                    valueCount++;
-
-                    newInstr = createTAC(TAC_ASSIGN, resultStr, NULL, curr->result);
-                } else {
-                    newInstr = createTAC(TAC_MUL, left, right, curr->result);
-                }
-                break;
-            }
-            case TAC_DIV: {
-                char* left = curr->arg1;
-                char* right = curr->arg2;
-
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, left) == 0) {
-                        left = values[i].value;
-                        break;
-                    }
-                }
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, right) == 0) {
-                        right = values[i].value;
-                        break;
-                    }
-                }
+/* A new definition of var: forget whatever was known about it */
+static void killValue(ValueTable* values, TACOperand var) {
+    int id = valueId(var);
+    if (id < 0) return;
+    values->entries[id].gen = 0;
+    values->version[id]++;
+}
+
+static void recordValue(ValueTable* values, TACOperand var, TACOperand value) {
+    int id = valueId(var);
+    if (id < 0) return;
+    killValue(values, var);
+    ValueEntry* e = &values->entries[id];
+    e->value = value;
+    e->gen = values->gen;
+    e->src = valueId(value);
+    e->srcVersion = e->src >= 0 ? values->version[e->src] : 0;
+    e->epoch = values->epoch;
+}
+
+/* Fold an integer operation with constant operands; returns 0 if it can't.
+   Arithmetic wraps like the 32-bit MIPS add/sub/mult/sll/sra/srl it replaces. */
+int foldInt(TACOp op, int left, int right, int* result) {
+    switch (op) {
+        case TAC_ADD: *result = (int)((unsigned)left + (unsigned)right); return 1;
+        case TAC_SUB: *result = (int)((unsigned)left - (unsigned)right); return 1;
+        case TAC_MUL: *result = (int)((unsigned)left * (unsigned)right); return 1;
+        case TAC_DIV:
+            if (right == 0 || (left == INT_MIN && right == -1)) return 0;
+            *result = left / right;
+            return 1;
+        case TAC_SHL: *result = (int)((unsigned)left << (right & 31)); return 1;
+        case TAC_SRA: *result = left < 0 ? (int)~(~(unsigned)left >> (right & 31)) : left >> (right & 31); return 1;
+        case TAC_SRL: *result = (int)((unsigned)left >> (right & 31)); return 1;
+        default:
+            return 0;
+    }
+}
 
-                // Only fold if both are numeric and right != 0
-                if (isdigit(left[0]) && isdigit(right[0]) && atoi(right) != 0) {
-                    int result = atoi(left) / atoi(right);
-                    char* resultStr = malloc(20);
-                    sprintf(resultStr, "%d", result);
+/* Same for floating point; division by zero is left for run time */
+int foldFloat(TACOp op, double left, double right, double* result) {
+    switch (op) {
+        case TAC_ADD: *result = left + right; return 1;
+        case TAC_SUB: *result = left - right; return 1;
+        case TAC_MUL: *result = left * right; return 1;
+        case TAC_DIV:
+            if (right == 0.0) return 0;
+            *result = left / right;
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* A constant as stored into var: truncated for an int variable, widened
+   for a float one. Returns 0 when the value does not fit the variable. */
+int convertConstant(TACOperand* value, TACOperand var) {
+    if (var.kind != OPR_SYM) return 1;
+    int type = getSymbol(var.u.sym)->type;
+    if (type == TYPE_INT && value->kind == OPR_FLOAT) {
+        double f = value->u.fval;
+        if (!(f > (double)INT_MIN - 1 && f < (double)INT_MAX + 1)) return 0;
+        *value = intOperand((int)f);
+    } else if (type == TYPE_FLOAT && value->kind == OPR_INT) {
+        *value = floatOperand(value->u.ival);
+    }
+    return 1;
+}
 
-                    values[valueCount].var = strdup(curr->result);
-                    values[valueCount].value = resultStr;
-                    valueCount++;
+/* Constant folding and copy propagation over one function, rewriting in place */
+static void foldAndPropagate(TACFunction* fn, ValueTable* values) {
+    values->gen++;
+    inferFloatTemps(fn);
+    for (int i = 0; i < fn->count; i++) {
+        TACInstr* curr = &fn->code[i];
 
-                    newInstr = createTAC(TAC_ASSIGN, resultStr, NULL, curr->result);
+        switch(curr->op) {
+            case TAC_ADD:
+            case TAC_SUB:
+            case TAC_MUL:
+            case TAC_DIV:
+            case TAC_SHL:
+            case TAC_SRA:
+            case TAC_SRL: {
+                TACOperand left = propagate(values, curr->arg1);
+                TACOperand right = propagate(values, curr->arg2);
+                int result;
+
+                if (left.kind == OPR_INT && right.kind == OPR_INT &&
+                    foldInt(curr->op, left.u.ival, right.u.ival, &result)) {
+                    recordValue(values, curr->result, intOperand(result));
+                    *curr = createTAC(TAC_ASSIGN, intOperand(result), noOperand(), curr->result);
                 } else {
-                    newInstr = createTAC(TAC_DIV, left, right, curr->result);
+                    curr->arg1 = left;
+                    curr->arg2 = right;
                 }
                 break;
             }
-            
+
             case TAC_ASSIGN: {
-                char* value = curr->arg1;
-                
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, value) == 0) {
-                        value = values[i].value;
-                        break;
-                    }
-                }
-                
-                if (valueCount >= valuesCapacity) {
-                    valuesCapacity *= 2;
-                    values = realloc(values, sizeof(VarValue) * valuesCapacity);
-                    if (!values) {
-                        fprintf(stderr, "Out of memory in optimizeTAC (realloc)\n");
-                        exit(1);
-                    }
-                }
-                values[valueCount].var = strdup(curr->result);
-                values[valueCount].value = strdup(value);
-                valueCount++;
-                
-                newInstr = createTAC(TAC_ASSIGN, value, NULL, curr->result);
-                break;
-            }
-            
-            case TAC_PRINT: {
-                char* value = curr->arg1;
-                
-                for (int i = valueCount - 1; i >= 0; i--) {
-                    if (strcmp(values[i].var, value) == 0) {
-                        value = values[i].value;
-                        break;
-                    }
+                curr->arg1 = propagate(values, curr->arg1);
+                /* Uses of result see the value converted to its type */
+                TACOperand value = curr->arg1;
+                int isConst = value.kind == OPR_INT || value.kind == OPR_FLOAT;
+                if (isConst ? convertConstant(&value, curr->result)
+                            : curr->result.kind != OPR_SYM || isFloatOperand(value) == isFloatOperand(curr->result)) {
+                    recordValue(values, curr->result, value);
+                } else {
+                    killValue(values, curr->result);
                 }
-                
-                newInstr = createTAC(TAC_PRINT, value, NULL, NULL);
                 break;
             }
 
-            case TAC_DECL_ARRAY:
-                newInstr = createTAC(TAC_DECL_ARRAY, curr->arg1, NULL, curr->result);
+            case TAC_PRINT:
+                curr->arg1 = propagate(values, curr->arg1);
                 break;
 
-            case TAC_LOAD:
-                newInstr = createTAC(TAC_LOAD, curr->arg1, curr->arg2, curr->result);
+            case TAC_CALL:
+                /* The callee may assign any global */
+                values->epoch++;
+                killValue(values, curr->result);
                 break;
-            case TAC_LABEL:
-                newInstr = createTAC(TAC_LABEL, NULL, NULL, curr->result);
+
+            default:
+                /* Everything else is left unchanged; scalar results are redefined */
+                if (curr->op != TAC_STORE && curr->op != TAC_DECL_ARRAY) killValue(values, curr->result);
                 break;
-            case TAC_PARAM:
-                newInstr = createTAC(TAC_PARAM, curr->arg1, NULL, NULL);
+        }
+    }
+}
+
+/* LIVENESS AND DEAD-CODE ELIMINATION
+ * A function body is straight-line code, so one backward scan with a
+ * single live set is exact. An instruction whose only effect is writing a
+ * temp or scalar variable that is not live afterwards is tombstoned.
+ * Globals are live at the end of a function (not of main: the program
+ * ends there) and at every call, since the callee may read them.
+ */
+
+/* Does this instruction only compute its result (no other side effects)? */
+static int isPureDef(TACInstr* in) {
+    return definesResult(in->op) && in->op != TAC_CALL && in->op != TAC_PHI;
+}
+
+static void addUse(Bitset* live, TACOperand op) {
+    int id = valueId(op);
+    if (id >= 0) bitsetAdd(live, id);
+}
+
+static void removeFromSet(Bitset* set, TACOperand op) {
+    int id = valueId(op);
+    if (id >= 0) bitsetRemove(set, id);
+}
+
+/* Empty the live set by clearing the operands of code[from..to) */
+static void clearLive(Bitset* live, TACFunction* fn, int from, int to) {
+    for (int i = from; i < to; i++) {
+        removeFromSet(live, fn->code[i].arg1);
+        removeFromSet(live, fn->code[i].arg2);
+        removeFromSet(live, fn->code[i].result);
+    }
+}
+
+static void addGlobals(Bitset* live, int* globals, int globalCount) {
+    for (int g = 0; g < globalCount; g++) bitsetAdd(live, globals[g]);
+}
+
+static int* fnGlobals = NULL;    /* Scratch for removeDeadCode, reused across functions */
+static int fnGlobalCapacity = 0;
+
+/* live must be empty on entry and is left empty on return */
+static void removeDeadCode(TACFunction* fn, int isMain, Bitset* live) {
+    /* Globals mentioned in this function (deduplicated through live) */
+    int globalCount = 0;
+    for (int i = 0; i < fn->count; i++) {
+        TACOperand ops[3] = { fn->code[i].arg1, fn->code[i].arg2, fn->code[i].result };
+        for (int k = 0; k < 3; k++) {
+            if (ops[k].kind != OPR_SYM || getSymbol(ops[k].u.sym)->scope != 0) continue;
+            if (bitsetContains(live, ops[k].u.sym)) continue;
+            bitsetAdd(live, ops[k].u.sym);
+            if (globalCount == fnGlobalCapacity) {
+                fnGlobalCapacity = fnGlobalCapacity ? fnGlobalCapacity * 2 : 64;
+                fnGlobals = xrealloc(fnGlobals, sizeof(int) * fnGlobalCapacity);
+            }
+            fnGlobals[globalCount++] = ops[k].u.sym;
+        }
+    }
+    if (isMain) clearLive(live, fn, 0, fn->count);
+
+    int segmentEnd = fn->count;   /* live only holds operands of code[i+1..segmentEnd) */
+    for (int i = fn->count - 1; i >= 0; i--) {
+        TACInstr* in = &fn->code[i];
+
+        if (in->op == TAC_RETURN) {
+            /* Whatever follows a return is not reached from here */
+            clearLive(live, fn, i + 1, segmentEnd);
+            segmentEnd = i + 1;
+            if (!isMain) addGlobals(live, fnGlobals, globalCount);
+            addUse(live, in->arg1);
+            continue;
+        }
+
+        if (isPureDef(in)) {
+            int def = valueId(in->result);
+            if (def >= 0 && !bitsetContains(live, def)) {
+                in->op = TAC_NOP;
+                continue;
+            }
+        }
+
+        switch (in->op) {
+            case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV:
+            case TAC_SHL: case TAC_SRA: case TAC_SRL:
+            case TAC_ASSIGN: case TAC_LOAD:
+                removeFromSet(live, in->result);
+                addUse(live, in->arg1);
+                addUse(live, in->arg2);
                 break;
             case TAC_CALL:
-                newInstr = createTAC(TAC_CALL, curr->arg1, NULL, curr->result);
-                newInstr->paramCount = curr->paramCount;
-                break;
-            case TAC_RETURN:
-                newInstr = createTAC(TAC_RETURN, curr->arg1, NULL, NULL);
+                removeFromSet(live, in->result);
+                addGlobals(live, fnGlobals, globalCount);
                 break;
-            case TAC_FUNC_BEGIN:
-                newInstr = createTAC(TAC_FUNC_BEGIN, NULL, NULL, curr->result);
-                break;
-            case TAC_FUNC_END:
-                newInstr = createTAC(TAC_FUNC_END, NULL, NULL, curr->result);
+            case TAC_STORE:
+                /* Arrays are never removed; the store reads the array too */
+                addUse(live, in->result);
+                addUse(live, in->arg1);
+                addUse(live, in->arg2);
                 break;
-            default: {
-                /* Preserve unknown or unhandled ops by copying raw strings */
-                newInstr = createTAC(curr->op, curr->arg1, curr->arg2, curr->result);
-                newInstr->paramCount = curr->paramCount;
+            case TAC_PRINT:
+            case TAC_PARAM:
+                addUse(live, in->arg1);
                 break;
-            }
-            
-            case TAC_STORE:
-                newInstr = createTAC(TAC_STORE, curr->arg1, curr->arg2, curr->result);
+            default:
                 break;
         }
-        
-        if (newInstr) {
-            appendOptimizedTAC(newInstr);
-        }
-
-        curr = curr->next;
     }
 
-    /* Cleanup propagation table memory */
-    for (int i = 0; i < valueCount; i++) {
-        free(values[i].var);
-        free(values[i].value);
-    }
-    free(values);
-
-    // After building the optimized list, run a simple dead-code elimination
-    // that removes instructions that write to temporaries (t*) which are
-    // never used later.
-    // Build a table of used variable names by scanning args in the optimized list
-    TACInstr* scan = optimizedList.head;
-    int maxUsed = 2048;
-    char** used = malloc(sizeof(char*) * maxUsed);
-    int usedCount = 0;
-
-    while (scan) {
-        if (scan->arg1) {
-            if (usedCount < maxUsed) used[usedCount++] = scan->arg1;
-        }
-        if (scan->arg2) {
-            if (usedCount < maxUsed) used[usedCount++] = scan->arg2;
+    clearLive(live, fn, 0, segmentEnd);
+    for (int g = 0; g < globalCount; g++) bitsetRemove(live, fnGlobals[g]);
+    compactTAC(fn);
+}
+
+// Simple optimization: constant folding and copy propagation
+static long countMulDiv() {
+    long count = 0;
+    for (int f = 0; f < tacProgram.funcCount; f++) {
+        for (int i = 0; i < tacProgram.funcs[f].count; i++) {
+            TACOp op = tacProgram.funcs[f].code[i].op;
+            if (op == TAC_MUL || op == TAC_DIV) count++;
         }
-        scan = scan->next;
     }
+    return count;
+}
 
-    // Rebuild list skipping dead writes to temporaries that aren't in 'used'
-    TACInstr* newHead = NULL;
-    TACInstr* newTail = NULL;
-    scan = optimizedList.head;
-    while (scan) {
-        bool skip = false;
-        if (scan->result && scan->result[0] == 't') {
-            // check if result is referenced in used[]
-            bool referenced = false;
-            for (int i = 0; i < usedCount; i++) {
-                if (strcmp(used[i], scan->result) == 0) { referenced = true; break; }
-            }
-            if (!referenced) {
-                // safe to drop this instruction
-                skip = true;
-            }
-        }
+/* Constant folding and copy propagation over every function */
+void foldConstants() {
+    /* One entry per value, allocated once for the whole program */
+    int n = valueCount();
+    ValueTable values;
+    values.entries = calloc(n ? n : 1, sizeof(ValueEntry));
+    values.version = calloc(n ? n : 1, sizeof(int));
+    if (!values.entries || !values.version) {
+        fprintf(stderr, "Out of memory in foldConstants\n");
+        exit(1);
+    }
+    values.gen = 0;
+    values.epoch = 0;
 
-        TACInstr* next = scan->next;
-        if (!skip) {
-            // append to new list
-            scan->next = NULL;
-            if (!newHead) newHead = newTail = scan;
-            else { newTail->next = scan; newTail = scan; }
-        } else {
-            // unlink and free the strings owned by this instr to avoid leaks
-            if (scan->arg1) free(scan->arg1);
-            if (scan->arg2) free(scan->arg2);
-            if (scan->result) free(scan->result);
-            free(scan);
-        }
+    for (int f = 0; f < tacProgram.funcCount; f++) foldAndPropagate(&tacProgram.funcs[f], &values);
 
-        scan = next;
+    free(values.entries);
+    free(values.version);
+}
+
+/* Dead-code elimination over every function */
+void eliminateDeadCode() {
+    Bitset* live = bitsetCreate(valueCount());
+    for (int f = 0; f < tacProgram.funcCount; f++) removeDeadCode(&tacProgram.funcs[f], f == 0, live);
+    bitsetFree(live);
+}
+
+/* Run the selected pass pipeline (see pipeline.h) */
+void optimizeTAC() {
+    optStats.mulDivBefore += countMulDiv();
+    runPipeline();
+    optStats.mulDivAfter += countMulDiv();
+}
+
+void printOptimizerStats() {
+    printf("\n=== OPTIMIZER STATISTICS ===\n");
+    printf("Inlining: %ld calls inlined, %ld functions removed\n",
+           optStats.inlinedCalls, optStats.inlineRemoved);
+    printf("IPCP: %ld parameters made constant, %ld specialized clones created\n",
+           optStats.ipcpConstants, optStats.ipcpClones);
+    printf("SCCP: %ld instructions folded, %ld operands replaced by constants, %ld unreachable instructions removed\n",
+           optStats.sccpFolded, optStats.sccpOperands, optStats.sccpUnreachable);
+    printf("Algebraic: %ld identities applied, %ld constant chains reassociated\n",
+           optStats.algebraicIdentities, optStats.reassociated);
+    printf("Rebalancing: %ld ADD/MUL chains rebuilt as balanced trees\n", optStats.rebalancedChains);
+    long* lvn = optStats.lvnEliminated;
+    printf("LVN: %ld redundant computations replaced (ADD %ld, SUB %ld, MUL %ld, DIV %ld, LOAD %ld)\n",
+           lvn[TAC_ADD] + lvn[TAC_SUB] + lvn[TAC_MUL] + lvn[TAC_DIV] + lvn[TAC_LOAD],
+           lvn[TAC_ADD], lvn[TAC_SUB], lvn[TAC_MUL], lvn[TAC_DIV], lvn[TAC_LOAD]);
+    long* gvn = optStats.gvnEliminated;
+    printf("GVN: %ld redundant computations replaced (ADD %ld, SUB %ld, MUL %ld, DIV %ld)\n",
+           gvn[TAC_ADD] + gvn[TAC_SUB] + gvn[TAC_MUL] + gvn[TAC_DIV],
+           gvn[TAC_ADD], gvn[TAC_SUB], gvn[TAC_MUL], gvn[TAC_DIV]);
+    printf("Strength reduction: %ld multiplications and %ld divisions replaced by shifts\n",
+           optStats.strengthMul, optStats.strengthDiv);
+    printf("MUL/DIV instructions: %ld before optimization, %ld after\n",
+           optStats.mulDivBefore, optStats.mulDivAfter);
+    printf("============================\n\n");
+}
+
+const char* formatTAC(TACInstr* curr, char* buf, int size) {
+    char a1[64], a2[64], res[64];
+    operandToString(curr->arg1, a1, sizeof(a1));
+    operandToString(curr->arg2, a2, sizeof(a2));
+    operandToString(curr->result, res, sizeof(res));
+    switch(curr->op) {
+        case TAC_DECL:
+            snprintf(buf, size, "DECL %s", res);
+            break;
+        case TAC_ADD:
+            snprintf(buf, size, "%s = %s + %s", res, a1, a2);
+            break;
+        case TAC_MUL:
+            snprintf(buf, size, "%s = %s * %s", res, a1, a2);
+            break;
+        case TAC_DIV:
+            snprintf(buf, size, "%s = %s / %s", res, a1, a2);
+            break;
+        case TAC_SUB:
+            snprintf(buf, size, "%s = %s - %s", res, a1, a2);
+            break;
+        case TAC_ASSIGN:
+            snprintf(buf, size, "%s = %s", res, a1);
+            break;
+        case TAC_PRINT:
+            snprintf(buf, size, "PRINT %s", a1);
+            break;
+        case TAC_DECL_ARRAY:
+            snprintf(buf, size, "DECL_ARRAY %s[%s]", res, a1);
+            break;
+        case TAC_STORE:
+            snprintf(buf, size, "%s[%s] = %s", res, a1, a2);
+            break;
+        case TAC_LOAD:
+            snprintf(buf, size, "%s = %s[%s]", res, a1, a2);
+            break;
+        case TAC_SHL:
+            snprintf(buf, size, "%s = %s << %s", res, a1, a2);
+            break;
+        case TAC_SRA:
+            snprintf(buf, size, "%s = %s >> %s", res, a1, a2);
+            break;
+        case TAC_SRL:
+            snprintf(buf, size, "%s = %s >>> %s", res, a1, a2);
+            break;
+        case TAC_LABEL:
+            snprintf(buf, size, "LABEL %s", res);
+            break;
+        case TAC_PARAM:
+            snprintf(buf, size, "PARAM %s", a1);
+            break;
+        case TAC_CALL:
+            snprintf(buf, size, "%s = CALL %s, %d", res, a1, curr->paramCount);
+            break;
+        case TAC_RETURN:
+            if (curr->arg1.kind != OPR_NONE) snprintf(buf, size, "RETURN %s", a1);
+            else snprintf(buf, size, "RETURN");
+            break;
+        case TAC_FUNC_BEGIN:
+            snprintf(buf, size, "FUNC_BEGIN %s", res);
+            break;
+        case TAC_FUNC_END:
+            snprintf(buf, size, "FUNC_END %s", res);
+            break;
+        case TAC_PHI: {
+            int len = snprintf(buf, size, "%s = PHI(", res);
+            for (int i = 0; i < curr->paramCount && len < size; i++) {
+                operandToString(tacProgram.phiArgs[curr->arg1.u.ival + i], a1, sizeof(a1));
+                len += snprintf(buf + len, size - len, "%s%s", i ? ", " : "", a1);
+            }
+            if (len < size) snprintf(buf + len, size - len, ")");
+            break;
+        }
+        default:
+            buf[0] = '\0';
+            break;
     }
+    return buf;
+}
 
-    optimizedList.head = newHead;
-    optimizedList.tail = newTail;
-    free(used);
+static void printOptimizedInstr(TACInstr* curr) {
+    char text[256];
+    printf("%s\n", formatTAC(curr, text, sizeof(text)));
 }
 
 void printOptimizedTAC() {
     printf("\nOptimized TAC Instructions:\n");
     printf("───────────────────────────\n");
-    TACInstr* curr = optimizedList.head;
-    int lineNum = 1;
-    while (curr) {
-        printf("%2d: ", lineNum++);
-        switch(curr->op) {
-            case TAC_DECL:
-                printf("DECL %s\n", curr->result);
-                break;
-            case TAC_ADD:
-                printf("%s = %s + %s\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            case TAC_MUL:
-                printf("%s = %s * %s\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            case TAC_DIV:
-                printf("%s = %s / %s\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            case TAC_SUB:
-                printf("%s = %s - %s\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            case TAC_ASSIGN:
-                printf("%s = %s\n", curr->result, curr->arg1);
-                break;
-            case TAC_PRINT:
-                printf("PRINT %s\n", curr->arg1);
-                break;
-            case TAC_DECL_ARRAY:
-                printf("DECL_ARRAY %s[%s]\n", curr->result, curr->arg1);
-                break;
-            case TAC_STORE:
-                printf("%s[%s] = %s\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            case TAC_LOAD:
-                printf("%s = %s[%s]\n", curr->result, curr->arg1, curr->arg2);
-                break;
-            default:
-                break;
-        }
-        curr = curr->next;
-    }
-}
\ No newline at end of file
+    printProgram(printOptimizedInstr);
+}
@@ -28,36 +28,140 @@ typedef enum {
     ,TAC_RETURN
     ,TAC_FUNC_BEGIN
     ,TAC_FUNC_END
+    ,TAC_NOP        /* Deleted instruction (tombstone), removed by compactTAC */
+    ,TAC_PHI        /* SSA join: result = PHI(args); paramCount args start at phiArgs[arg1] */
+    ,TAC_SHL        /* result = arg1 << arg2 */
+    ,TAC_SRA        /* result = arg1 >> arg2, arithmetic (sign-filling) */
+    ,TAC_SRL        /* result = arg1 >>> arg2, logical (zero-filling) */
+    ,TAC_OP_COUNT   /* Number of opcodes (not an instruction) */
 } TACOp;
 
+/* TAC OPERANDS
+ * Operands are small tagged values stored inline in the instruction, so
+ * creating, copying and comparing them never allocates or parses text.
+ * Text is only produced when printing (operandToString).
+ */
+typedef enum {
+    OPR_NONE,       /* Unused operand slot */
+    OPR_TEMP,       /* Compiler temporary tN */
+    OPR_SYM,        /* Program variable: symbol table id */
+    OPR_INT,        /* Integer immediate */
+    OPR_FLOAT,      /* Float immediate */
+    OPR_LABEL       /* Function / label name: label table id */
+} OperandKind;
+
+typedef struct {
+    OperandKind kind;
+    int ver;            /* OPR_SYM in SSA form: version (0 = value on entry) */
+    union {
+        int temp;       /* OPR_TEMP: temporary number */
+        int sym;        /* OPR_SYM: symbol id */
+        int ival;       /* OPR_INT: value */
+        double fval;    /* OPR_FLOAT: value */
+        int label;      /* OPR_LABEL: label id */
+    } u;
+} TACOperand;
+
 /* TAC INSTRUCTION STRUCTURE */
-typedef struct TACInstr {
+typedef struct {
     TACOp op;               /* Operation type */
-    char* arg1;             /* First operand (if needed) */
-    char* arg2;             /* Second operand (for binary ops) */
-    char* result;           /* Result/destination */
+    TACOperand arg1;        /* First operand (if needed) */
+    TACOperand arg2;        /* Second operand (for binary ops) */
+    TACOperand result;      /* Result/destination */
     int paramCount;         /* For CALL instructions: number of params */
-    struct TACInstr* next;  /* Linked list pointer */
 } TACInstr;
 
-/* TAC LIST MANAGEMENT */
+/* TAC FUNCTIONS
+ * Each function's instructions live in one growable array and are
+ * addressed by index. Passes rewrite instructions in place and delete
+ * them by turning them into TAC_NOP; compactTAC squeezes the tombstones
+ * out in a single linear pass.
+ * Function 0 holds the top-level (main) code.
+ */
 typedef struct {
-    TACInstr* head;    /* First instruction */
-    TACInstr* tail;    /* Last instruction (for efficient append) */
-    int tempCount;     /* Counter for temporary variables (t0, t1, ...) */
-} TACList;
+    int name;          /* Label id of the function name */
+    int scope;         /* Symbol table scope (0 for main) */
+    int* params;       /* Symbol ids of the parameters, in order */
+    int paramCount;
+    TACInstr* code;    /* Instruction array */
+    int count;         /* Instructions in use */
+    int capacity;      /* Allocated instructions */
+} TACFunction;
+
+typedef struct {
+    TACFunction* funcs;   /* funcs[0] is main */
+    int funcCount;
+    int funcCapacity;
+    int tempCount;        /* Counter for temporary variables (t0, t1, ...) */
+    TACOperand* phiArgs;  /* Incoming values of every TAC_PHI, in predecessor order */
+    int phiArgCount;
+    int phiArgCapacity;
+} TACProgram;
+
+extern TACProgram tacProgram;
+
+/* OPERAND HELPERS */
+TACOperand noOperand();                                            /* Empty operand slot */
+TACOperand tempOperand(int temp);                                  /* Temporary tN */
+TACOperand symOperand(int sym);                                    /* Variable by symbol id */
+TACOperand intOperand(int value);                                  /* Integer immediate */
+TACOperand floatOperand(double value);                             /* Float immediate */
+TACOperand labelOperand(int label);                                /* Label by id */
+int sameOperand(TACOperand a, TACOperand b);                       /* Structural equality */
+int internLabel(const char* name);                                 /* Label id for a name */
+const char* labelName(int label);                                  /* Name of a label id */
+const char* operandToString(TACOperand op, char* buf, int size);   /* Printable form */
+int valueId(TACOperand op);                                        /* Dense id of a variable/temp, else -1 */
+int valueCount();                                                  /* Number of value ids */
+int definesResult(TACOp op);                                       /* Does op write its result operand? */
+int newPhiArgs(int count);                                         /* Reserve phi argument slots */
+void inferFloatTemps(TACFunction* fn);                             /* Work out which of fn's temps hold floats */
+int isFloatOperand(TACOperand op);                                 /* Float operand (temps: per inferFloatTemps) */
 
 /* TAC GENERATION FUNCTIONS */
-void initTAC();                                                    /* Initialize TAC lists */
-char* newTemp();                                                   /* Generate new temp variable */
-TACInstr* createTAC(TACOp op, char* arg1, char* arg2, char* result); /* Create TAC instruction */
-void appendTAC(TACInstr* instr);                                  /* Add instruction to list */
-void generateTAC(ASTNode* node);                                  /* Convert AST to TAC */
-char* generateTACExpr(ASTNode* node);                             /* Generate TAC for expression */
+void initTAC();                                                    /* Initialize TAC program */
+int addFunction(int name, int scope);                              /* Append an empty function, returns its index */
+TACOperand newTemp();                                              /* Generate new temp variable */
+TACInstr createTAC(TACOp op, TACOperand arg1, TACOperand arg2, TACOperand result); /* Create TAC instruction */
+int appendTAC(const TACInstr* instr);                             /* Add to current function, returns index */
+void compactTAC(TACFunction* fn);                                 /* Remove TAC_NOP tombstones */
+void generateTAC(ASTNode* node);                                  /* Convert AST to TAC (after resolveNames) */
+TACOperand generateTACExpr(ASTNode* node);                        /* Generate TAC for expression */
+
+/* CONSTANT FOLDING HELPERS (return 0 when the operation must not be folded) */
+int foldInt(TACOp op, int left, int right, int* result);
+int foldFloat(TACOp op, double left, double right, double* result);
+int convertConstant(TACOperand* value, TACOperand var);           /* To var's declared type; 0 if it can't */
+
+/* OPTIMIZER STATISTICS (reported with -stats) */
+typedef struct {
+    long inlinedCalls;      /* Call sites replaced by the callee's body */
+    long inlineRemoved;     /* Functions removed after all their calls were inlined */
+    long ipcpConstants;     /* Parameters given the constant every call site passes */
+    long ipcpClones;        /* Specialized copies made for constant arguments */
+    long sccpFolded;        /* Instructions SCCP reduced to a constant */
+    long sccpOperands;      /* Operands SCCP replaced by a constant */
+    long sccpUnreachable;   /* Unreachable instructions removed */
+    long lvnEliminated[TAC_OP_COUNT];   /* Redundant computations LVN replaced, by opcode */
+    long gvnEliminated[TAC_OP_COUNT];   /* Redundant computations GVN replaced, by opcode */
+    long algebraicIdentities; /* Identities such as x * 1 or x - x applied */
+    long reassociated;      /* Constants combined across chained ADD/SUB/MUL */
+    long rebalancedChains;  /* ADD/MUL chains rebuilt as balanced trees */
+    long strengthMul;       /* Multiplications reduced to shifts and adds */
+    long strengthDiv;       /* Divisions reduced to shifts */
+    long mulDivBefore;      /* MUL/DIV instructions entering the optimizer */
+    long mulDivAfter;       /* MUL/DIV instructions left after it */
+} OptStats;
+
+extern OptStats optStats;
+void printOptimizerStats();
 
 /* TAC OPTIMIZATION AND OUTPUT */
 void printTAC();                                                   /* Display unoptimized TAC */
 void optimizeTAC();                                                /* Apply optimizations */
+void foldConstants();                                              /* Constant folding and copy propagation */
+void eliminateDeadCode();                                          /* Remove unused computations */
 void printOptimizedTAC();                                          /* Display optimized TAC */
+const char* formatTAC(TACInstr* instr, char* buf, int size);      /* One instruction as text */
 
-#endif
\ No newline at end of file
+#endif
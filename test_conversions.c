@@ -0,0 +1,16 @@
+float f;
+int x;
+f = 3;
+x = 2.5;
+print(f / 2);
+print(x / 2);
+print(x * 2);
+
+int a;
+float g;
+int b;
+a = 7;
+g = 2.5;
+b = a * g;
+print(b);
+print(b + 57);